@@ -0,0 +1,131 @@
+#pragma once
+
+#include "dirty_tiles.h"
+#include "shared_array.h"
+#include "write_ring.h"
+#include <atomic>
+#include <climits>
+
+// Every write a sort kernel makes to the shared array goes through these
+// helpers so the renderer can find out what changed without rescanning it.
+// The writing thread may read the array directly; nobody else writes it.
+
+inline DirtyTiles dirtyTiles;
+
+// Only set when write events are enabled; the ring is single-producer, so it
+// must only be used by kernels that write from one thread.
+inline WriteRing* writeRing = nullptr;
+
+// Number of slots i with arr[i] == i. Each writing thread accumulates its
+// changes locally and folds them in every PLACED_FLUSH_WRITES writes (sooner
+// at a flushDeadline), so the shared counter is only touched once per batch;
+// call flush_placed_count() when a thread stops writing to make the count
+// exact.
+constexpr int PLACED_FLUSH_WRITES = 4096;
+
+inline std::atomic<int> placedCount(0);
+
+struct PlacedBatch {
+    int delta = 0;
+    int writes = 0;
+    // Writes after which this batch is folded in; 0 until the first fold.
+    int limit = 0;
+};
+
+inline thread_local PlacedBatch placedBatch;
+
+// Total writes folded in so far, and callbacks run by the writing thread
+// after each fold with the new total (frame export uses one to stop the sort
+// at fixed write counts, the frame pacer one to wake an idle render loop).
+// Hooks are added before any sort thread starts.
+constexpr int FLUSH_HOOK_SLOTS = 4;
+
+typedef void (*FlushHook)(long long writes);
+
+inline std::atomic<long long> writeCount(0);
+inline FlushHook flushHooks[FLUSH_HOOK_SLOTS] = {};
+inline int flushHookCount = 0;
+
+// Total at which a hook must run even if the batch is not full yet (frame
+// export sets it to its next capture point). Batches are cut short to end
+// there, so it is exact with a single writing thread.
+inline std::atomic<long long> flushDeadline(LLONG_MAX);
+
+inline bool add_flush_hook(FlushHook hook) {
+    if (flushHookCount == FLUSH_HOOK_SLOTS) {
+        return false;
+    }
+    flushHooks[flushHookCount++] = hook;
+    return true;
+}
+
+inline void flush_placed_count() {
+    placedCount.fetch_add(placedBatch.delta, std::memory_order_relaxed);
+    long long writes = writeCount.fetch_add(placedBatch.writes, std::memory_order_relaxed) + placedBatch.writes;
+    placedBatch.delta = 0;
+    placedBatch.writes = 0;
+
+    for (int i = 0; i < flushHookCount; i++) {
+        flushHooks[i](writes);
+    }
+
+    long long untilDeadline = flushDeadline.load(std::memory_order_relaxed) - writes;
+    placedBatch.limit = untilDeadline > 0 && untilDeadline < PLACED_FLUSH_WRITES ? static_cast<int>(untilDeadline) : PLACED_FLUSH_WRITES;
+}
+
+inline int placed_count() {
+    return placedCount.load(std::memory_order_relaxed);
+}
+
+inline int count_placed(const int arr[], int begin, int end) {
+    int placed = 0;
+    for (int i = begin; i < end; i++) {
+        placed += arr[i] == i;
+    }
+    return placed;
+}
+
+inline void array_tracking_init(const int arr[], int elements) {
+    dirty_tiles_init(dirtyTiles, elements);
+    placedCount = count_placed(arr, 0, elements);
+}
+
+// Set by the window thread when the window is closed mid-sort. The sort has
+// no other way out of a kernel (bogosort never ends on its own), so the next
+// batch fold after it is set throws SortCancelled out of the kernel; whoever
+// runs a kernel on a thread catches it there. The array is left in whatever
+// state the kernel had reached.
+struct SortCancelled {};
+
+inline std::atomic<bool> sortCancelled(false);
+
+// Off only in sort_bench, to time kernels on their own cost: writes are then
+// plain stores, and neither the placed count nor any dirty state follows
+// them. Set before the sort starts.
+inline bool trackWrites = true;
+
+inline void set_element(int arr[], int index, int value) {
+    if (!trackWrites) {
+        store_element(arr, index, value);
+        return;
+    }
+    placedBatch.delta += (value == index) - (arr[index] == index);
+    store_element(arr, index, value);
+    if (++placedBatch.writes >= placedBatch.limit) {
+        flush_placed_count();
+        if (sortCancelled.load(std::memory_order_relaxed)) {
+            throw SortCancelled();
+        }
+    }
+
+    if (writeRing != nullptr && write_ring_push(*writeRing, index, value)) {
+        return;
+    }
+    mark_dirty(dirtyTiles, index);
+}
+
+inline void swap_elements(int arr[], int a, int b) {
+    int t = arr[a];
+    set_element(arr, a, arr[b]);
+    set_element(arr, b, t);
+}
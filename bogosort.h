@@ -0,0 +1,32 @@
+#pragma once
+
+#include "array_access.h"
+#include <random>
+#include <chrono>
+
+inline bool is_sorted(int arr[], int n) {
+    for (int i = 0; i < n - 1; ++i) {
+        if (arr[i] > arr[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void shuffle_array(int arr[], int n) {
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    std::default_random_engine engine(seed);
+
+    // Fisher-Yates by hand instead of std::shuffle, so every write goes
+    // through swap_elements.
+    for (int i = n - 1; i > 0; --i) {
+        std::uniform_int_distribution<int> pick(0, i);
+        swap_elements(arr, i, pick(engine));
+    }
+}
+
+inline void bogo_sort(int arr[], int n) {
+    while (!is_sorted(arr, n)) {
+        shuffle_array(arr, n);
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "array_access.h"
+
+inline void bubble_sort(int arr[], int size) {
+    for (int i = 0; i < size - 1; ++i) {
+        for (int j = 0; j < size - i - 1; ++j) {
+            if (arr[j] > arr[j + 1]) {
+                swap_elements(arr, j, j + 1);
+            }
+        }
+    }
+}
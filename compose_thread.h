@@ -0,0 +1,119 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "compositor.h"
+#include "frame_export.h"
+#include "frame_handoff.h"
+#include "frame_pacer.h"
+#include <atomic>
+
+// Runs composition on its own thread so the window thread only handles input
+// and presents finished frames, however long a frame takes to composite.
+// The compositor thread owns the Compositor's frame state while it runs; the
+// window thread only uses the renderer side of it (present_pixels).
+
+struct ComposeLoop {
+    Compositor* compositor;
+    const int* arr;
+    int pixels;
+    const std::atomic<bool>* sortingFinished;
+    float updateFrequency;
+    FramePacer* pacer;
+    FrameHandoff* handoff;
+    FrameExporter* exporter;
+    std::atomic<bool> quit{false};
+    std::atomic<bool> finished{false};
+    // Latest view asked for by the window thread, picked up on the next frame.
+    SDL_SpinLock viewLock = 0;
+    Viewport requestedView{};
+    bool viewRequested = false;
+};
+
+// Window side: asks the compositor thread to show a different part of the
+// image from its next frame on.
+inline void compose_loop_request_view(ComposeLoop& loop, const Viewport& view) {
+    SDL_AtomicLock(&loop.viewLock);
+    loop.requestedView = view;
+    loop.viewRequested = true;
+    SDL_AtomicUnlock(&loop.viewLock);
+    pacer_wake();
+}
+
+inline bool take_view_request(ComposeLoop& loop, Viewport& view) {
+    SDL_AtomicLock(&loop.viewLock);
+    bool requested = loop.viewRequested;
+    view = loop.requestedView;
+    loop.viewRequested = false;
+    SDL_AtomicUnlock(&loop.viewLock);
+    return requested;
+}
+
+// Recorded frames always show the whole image, whatever the window is
+// zoomed or panned to, so a recording only depends on --seed and
+// --export-every. A zoomed view is switched out for the capture and composed
+// again afterwards.
+inline void compose_export_frame(Compositor& compositor, const int arr[], FrameExporter& exporter) {
+    Viewport view = compositor.view;
+    Viewport full = full_view(compositor.srcWidth, compositor.srcHeight);
+    bool zoomed = view.x != full.x || view.y != full.y || view.width != full.width || view.height != full.height;
+
+    if (zoomed) {
+        compositor_set_view(compositor, full);
+    }
+    compose_frame(compositor, arr);
+    export_frame(exporter, compositor.frame);
+    if (zoomed) {
+        compositor_set_view(compositor, view);
+        compose_frame(compositor, arr);
+    }
+}
+
+inline int compose_loop(void* data) {
+    ComposeLoop& loop = *static_cast<ComposeLoop*>(data);
+    Compositor& compositor = *loop.compositor;
+
+    while (!loop.quit.load(std::memory_order_acquire)) {
+        if (*loop.sortingFinished == true && placed_count() == loop.pixels) {
+            break;
+        }
+
+        if (loop.exporter != nullptr && export_pending(*loop.exporter)) {
+            compose_export_frame(compositor, loop.arr, *loop.exporter);
+            export_release(*loop.exporter);
+        }
+
+        if (pacer_frame_due(*loop.pacer)) {
+            Viewport view;
+            if (take_view_request(loop, view)) {
+                compositor_set_view(compositor, view);
+                compose_frame(compositor, loop.arr);
+            }
+            if (writeRing != nullptr) {
+                compose_events(compositor, loop.arr, *writeRing);
+            }
+            int counter = compose_dirty(compositor, loop.arr, dirtyTiles);
+            bool changed = frame_changed(compositor);
+
+            if (changed && counter > loop.updateFrequency) {
+                handoff_publish(*loop.handoff, compositor.frame, compositor.view);
+                compositor.uploadFirst = compositor.dstHeight;
+                compositor.uploadLast = -1;
+            }
+            pacer_frame_done(*loop.pacer, changed);
+        }
+
+        pacer_wait(*loop.pacer);
+    }
+
+    loop.finished.store(true, std::memory_order_release);
+    handoff_notify(*loop.handoff);
+    return 0;
+}
+
+// Asks the compositor thread to stop and waits for it.
+inline void compose_loop_stop(ComposeLoop& loop, SDL_Thread* thread) {
+    loop.quit.store(true, std::memory_order_release);
+    pacer_wake();
+    SDL_WaitThread(thread, nullptr);
+}
@@ -0,0 +1,193 @@
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "compositor.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+
+#undef main
+
+// Times a full-window compose_frame with every compositing kernel the CPU
+// supports, then with the fastest one split across compose workers, on an
+// array where about half of the elements are in place. Runs once for the
+// normal view and once for the scramble view, then compares the slot-to-pixel
+// mappings.
+
+constexpr int BENCH_FRAMES = 200;
+constexpr int BENCH_RUNS = 500;
+
+const int WINDOW_WIDTH = 1000;
+const int WINDOW_HEIGHT = 600;
+
+double time_frames(Compositor& compositor, const int arr[]) {
+    compose_frame(compositor, arr);
+
+    auto timer_start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        compose_frame(compositor, arr);
+    }
+    auto timer_end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(timer_end - timer_start).count() / BENCH_FRAMES;
+}
+
+// Times every kernel, then the last one with 1, 2, 4, ... compose workers,
+// checking each result against the scalar kernel. The scramble view also
+// reports how fast it gathers: every window pixel reads one array slot and
+// one image pixel.
+bool bench_view(Compositor& compositor, const int arr[], const std::vector<CompositeKernels>& kernels, const char* view) {
+    std::cout << view << ":" << std::endl;
+    double gathered = 2.0 * sizeof(Uint32) * compositor.dstWidth * compositor.dstHeight;
+
+    std::vector<Uint32> reference;
+    double baseline = 0;
+    for (const CompositeKernels& kernel : kernels) {
+        compositor.kernels = kernel;
+        double frameTime = time_frames(compositor, arr);
+
+        if (reference.empty()) {
+            reference = compositor.frame;
+            baseline = frameTime;
+        } else if (reference != compositor.frame) {
+            std::cerr << kernel.name << " does not match the scalar kernel!" << std::endl;
+            return false;
+        }
+
+        std::cout << kernel.name << ": " << frameTime << "ms/frame, " << baseline / frameTime << "x";
+        if (compositor.scramble) {
+            std::cout << ", " << gathered / frameTime / 1e6 << " GB/s gathered";
+        }
+        std::cout << std::endl;
+    }
+
+    compositor.kernels = kernels.back();
+    for (int threads = 1; threads < SDL_GetCPUCount(); threads *= 2) {
+        if (!compositor_start_workers(compositor, threads)) {
+            std::cerr << "Compose workers could not be started! SDL_Error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        double frameTime = time_frames(compositor, arr);
+        compositor_stop_workers(compositor);
+
+        if (reference != compositor.frame) {
+            std::cerr << threads << " workers do not match the scalar kernel!" << std::endl;
+            return false;
+        }
+
+        std::cout << compositor.kernels.name << " + " << threads << " workers: " << frameTime << "ms/frame, " << baseline / frameTime << "x";
+        if (compositor.scramble) {
+            std::cout << ", " << gathered / frameTime / 1e6 << " GB/s gathered";
+        }
+        std::cout << std::endl;
+    }
+
+    return true;
+}
+
+// Marks runs of runLength consecutive slots dirty, the way a partition or
+// merge pass writes them, and reports how many window pixels and how long
+// compose_dirty takes to redraw each run. runLength must not exceed the
+// array.
+void bench_runs(Compositor& compositor, const int arr[], int runLength, std::default_random_engine& engine) {
+    long long composed = compositor.composedPixels;
+    double total = 0;
+    int starts = dirtyTiles.elements - runLength + 1;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        int begin = static_cast<int>(engine() % static_cast<unsigned>(starts));
+        mark_range_dirty(dirtyTiles, begin, begin + runLength);
+
+        auto timer_start = std::chrono::high_resolution_clock::now();
+        compose_dirty(compositor, arr, dirtyTiles);
+        auto timer_end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(timer_end - timer_start).count();
+    }
+
+    std::cout << "  runs of " << runLength << " slots: " << (compositor.composedPixels - composed) / BENCH_RUNS << " pixels, " << total / BENCH_RUNS << "ms per run" << std::endl;
+}
+
+// Full frame time and dirty-region size of every mapping, with the fastest
+// kernel and no workers.
+void bench_mappings(Compositor& compositor, const int arr[]) {
+    std::cout << "mappings:" << std::endl;
+    for (IndexMapping mapping : { MAPPING_ROW_MAJOR, MAPPING_MORTON, MAPPING_HILBERT }) {
+        compositor_set_mapping(compositor, mapping);
+        std::cout << mapping_name(mapping) << ": " << time_frames(compositor, arr) << "ms/frame" << std::endl;
+
+        compose_dirty(compositor, arr, dirtyTiles);
+        std::default_random_engine engine(7);
+        for (int runLength : { DIRTY_TILE_SIZE, 16 * DIRTY_TILE_SIZE, 256 * DIRTY_TILE_SIZE }) {
+            if (runLength > dirtyTiles.elements) {
+                std::cout << "  runs of " << runLength << " slots: longer than the array, skipped" << std::endl;
+                continue;
+            }
+            bench_runs(compositor, arr, runLength, engine);
+        }
+    }
+    compositor_set_mapping(compositor, MAPPING_ROW_MAJOR);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : "images/image1280\xC3\x97" "853.bmp";
+    SDL_Surface* surface = SDL_LoadBMP(path);
+    if (surface == nullptr) {
+        std::cerr << "Failed to load image! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    Compositor compositor;
+    bool composited = compositor_load(compositor, surface, WINDOW_WIDTH, WINDOW_HEIGHT);
+    SDL_FreeSurface(surface);
+    if (!composited) {
+        std::cerr << "Failed to convert image! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    const int pixels = compositor.srcWidth * compositor.srcHeight;
+
+    // Shuffle a random half of the slots among themselves.
+    std::vector<int> arr(pixels);
+    std::vector<int> slots;
+    std::default_random_engine engine(42);
+    for (int i = 0; i < pixels; i++) {
+        arr[i] = i;
+        if (engine() % 2 == 0) {
+            slots.push_back(i);
+        }
+    }
+    std::vector<int> values = slots;
+    std::shuffle(values.begin(), values.end(), engine);
+    for (size_t i = 0; i < slots.size(); i++) {
+        arr[slots[i]] = values[i];
+    }
+
+    std::vector<CompositeKernels> kernels = { SCALAR_KERNELS };
+#ifdef COMPOSITE_X86
+    if (SDL_HasSSE2()) {
+        kernels.push_back(SSE2_KERNELS);
+    }
+    if (SDL_HasAVX2()) {
+        kernels.push_back(AVX2_KERNELS);
+    }
+#endif
+
+    std::cout << compositor.srcWidth << "x" << compositor.srcHeight << " -> " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << ", " << BENCH_FRAMES << " frames, colors from pyramid level " << compositor.colorLevel << " of " << compositor.pyramid.levels.size() << std::endl;
+
+    compositor.scramble = false;
+    if (!bench_view(compositor, arr.data(), kernels, "placed view")) {
+        return 1;
+    }
+    compositor.scramble = true;
+    if (!bench_view(compositor, arr.data(), kernels, "scramble view")) {
+        return 1;
+    }
+
+    compositor.scramble = false;
+    dirty_tiles_init(dirtyTiles, pixels);
+    bench_mappings(compositor, arr.data());
+
+    return 0;
+}
+
+//g++ -O2 composite_bench.cpp -o composite_bench.exe -Iinc -Llib -lSDL2 -lopengl32
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "shared_array.h"
+
+// Vector loads of the array are not atomic, so sanitizer builds only get the
+// scalar kernels.
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && !defined(SHARED_ARRAY_SCALAR_ONLY)
+#define COMPOSITE_X86 1
+#include <immintrin.h>
+#endif
+
+// Per-row compositing kernels. Each one writes count window pixels: the
+// pixel's color where the element sampled for that pixel is in its final
+// slot, the background otherwise, and returns how many were placed. The SIMD
+// variants are picked at runtime from what the CPU reports through SDL.
+
+// Source pixels are stored fully opaque and the texture is copied without
+// blending, so a zero alpha marks a pixel as not yet placed while still
+// displaying as black.
+constexpr Uint32 BACKGROUND_COLOR = 0x00000000;
+constexpr Uint32 OPAQUE_ALPHA = 0xFF000000;
+
+// out[i] samples element rowOffset + columns[i] and shows colors[i], the
+// image prefiltered to the window's scale, so only the array is gathered.
+typedef int (*GatherKernel)(const int arr[], const Uint32 colors[], const int columns[], int rowOffset, Uint32 out[], int count);
+// out[i] samples element first + i, i.e. the row is drawn at 1:1 scale.
+typedef int (*ContiguousKernel)(const int arr[], const Uint32 source[], int first, Uint32 out[], int count);
+// Scramble view: out[i] shows the source pixel of the value currently in
+// slot rowOffset + columns[i], placed or not, so every pixel is gathered
+// twice (the array, then the image at that value).
+typedef int (*ScrambleKernel)(const int arr[], const Uint32 source[], const int columns[], int rowOffset, Uint32 out[], int count);
+
+struct CompositeKernels {
+    const char* name;
+    GatherKernel gather;
+    ContiguousKernel contiguous;
+    ScrambleKernel scramble;
+};
+
+inline int compose_gather_scalar(const int arr[], const Uint32 colors[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    for (int i = 0; i < count; i++) {
+        int currentPixel = rowOffset + columns[i];
+        if (currentPixel == load_element(arr, currentPixel)) {
+            out[i] = colors[i];
+            placed++;
+        } else {
+            out[i] = BACKGROUND_COLOR;
+        }
+    }
+    return placed;
+}
+
+inline int compose_contiguous_scalar(const int arr[], const Uint32 source[], int first, Uint32 out[], int count) {
+    int placed = 0;
+    for (int i = 0; i < count; i++) {
+        int currentPixel = first + i;
+        if (currentPixel == load_element(arr, currentPixel)) {
+            out[i] = source[currentPixel];
+            placed++;
+        } else {
+            out[i] = BACKGROUND_COLOR;
+        }
+    }
+    return placed;
+}
+
+inline int compose_scramble_scalar(const int arr[], const Uint32 source[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    for (int i = 0; i < count; i++) {
+        int currentPixel = rowOffset + columns[i];
+        int value = load_element(arr, currentPixel);
+        out[i] = source[value];
+        placed += value == currentPixel;
+    }
+    return placed;
+}
+
+#ifdef COMPOSITE_X86
+
+// The blends below are a plain AND with the compare mask.
+static_assert(BACKGROUND_COLOR == 0, "SIMD kernels assume a zero background");
+
+// SSE2 has no gather, so the scaled path only vectorizes the compare and
+// blend; the array loads stay scalar.
+__attribute__((target("sse2")))
+inline int compose_gather_sse2(const int arr[], const Uint32 colors[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    const int* rowArr = arr + rowOffset;
+    const __m128i offset = _mm_set1_epi32(rowOffset);
+    for (; i + 4 <= count; i += 4) {
+        __m128i index = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + i)), offset);
+        __m128i values = _mm_set_epi32(rowArr[columns[i + 3]], rowArr[columns[i + 2]], rowArr[columns[i + 1]], rowArr[columns[i]]);
+        __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + i));
+        __m128i mask = _mm_cmpeq_epi32(values, index);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(mask, color));
+        placed += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+    }
+    return placed + compose_gather_scalar(arr, colors + i, columns + i, rowOffset, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+inline int compose_contiguous_sse2(const int arr[], const Uint32 source[], int first, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    __m128i iota = _mm_add_epi32(_mm_set1_epi32(first), _mm_set_epi32(3, 2, 1, 0));
+    const __m128i step = _mm_set1_epi32(4);
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(arr + first + i));
+        __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + first + i));
+        __m128i mask = _mm_cmpeq_epi32(values, iota);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(mask, colors));
+        placed += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+        iota = _mm_add_epi32(iota, step);
+    }
+    return placed + compose_contiguous_scalar(arr, source, first + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+inline int compose_gather_avx2(const int arr[], const Uint32 colors[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    const __m256i offset = _mm256_set1_epi32(rowOffset);
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + i)), offset);
+        __m256i values = _mm256_i32gather_epi32(arr, index, 4);
+        __m256i color = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colors + i));
+        __m256i mask = _mm256_cmpeq_epi32(values, index);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(mask, color));
+        placed += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+    }
+    return placed + compose_gather_scalar(arr, colors + i, columns + i, rowOffset, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+inline int compose_scramble_sse2(const int arr[], const Uint32 source[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    const int* rowArr = arr + rowOffset;
+    const __m128i offset = _mm_set1_epi32(rowOffset);
+    for (; i + 4 <= count; i += 4) {
+        __m128i index = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + i)), offset);
+        int v0 = rowArr[columns[i]];
+        int v1 = rowArr[columns[i + 1]];
+        int v2 = rowArr[columns[i + 2]];
+        int v3 = rowArr[columns[i + 3]];
+        __m128i colors = _mm_set_epi32(source[v3], source[v2], source[v1], source[v0]);
+        __m128i mask = _mm_cmpeq_epi32(_mm_set_epi32(v3, v2, v1, v0), index);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), colors);
+        placed += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+    }
+    return placed + compose_scramble_scalar(arr, source, columns + i, rowOffset, out + i, count - i);
+}
+
+// Two dependent vpgatherdd per eight pixels: the slots, then the image at
+// the values found there.
+__attribute__((target("avx2")))
+inline int compose_scramble_avx2(const int arr[], const Uint32 source[], const int columns[], int rowOffset, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    const __m256i offset = _mm256_set1_epi32(rowOffset);
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + i)), offset);
+        __m256i values = _mm256_i32gather_epi32(arr, index, 4);
+        __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(source), values, 4);
+        __m256i mask = _mm256_cmpeq_epi32(values, index);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), colors);
+        placed += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+    }
+    return placed + compose_scramble_scalar(arr, source, columns + i, rowOffset, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+inline int compose_contiguous_avx2(const int arr[], const Uint32 source[], int first, Uint32 out[], int count) {
+    int placed = 0;
+    int i = 0;
+    __m256i iota = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    const __m256i step = _mm256_set1_epi32(8);
+    for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(arr + first + i));
+        __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + first + i));
+        __m256i mask = _mm256_cmpeq_epi32(values, iota);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(mask, colors));
+        placed += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+        iota = _mm256_add_epi32(iota, step);
+    }
+    return placed + compose_contiguous_scalar(arr, source, first + i, out + i, count - i);
+}
+
+#endif
+
+constexpr CompositeKernels SCALAR_KERNELS = { "scalar", compose_gather_scalar, compose_contiguous_scalar, compose_scramble_scalar };
+#ifdef COMPOSITE_X86
+constexpr CompositeKernels SSE2_KERNELS = { "sse2", compose_gather_sse2, compose_contiguous_sse2, compose_scramble_sse2 };
+constexpr CompositeKernels AVX2_KERNELS = { "avx2", compose_gather_avx2, compose_contiguous_avx2, compose_scramble_avx2 };
+#endif
+
+inline CompositeKernels select_composite_kernels() {
+#ifdef COMPOSITE_X86
+    if (SDL_HasAVX2()) {
+        return AVX2_KERNELS;
+    }
+    if (SDL_HasSSE2()) {
+        return SSE2_KERNELS;
+    }
+#endif
+    return SCALAR_KERNELS;
+}
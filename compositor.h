@@ -0,0 +1,719 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "composite_simd.h"
+#include "dirty_tiles.h"
+#include "image_pyramid.h"
+#include "index_mapping.h"
+#include "partition_stats.h"
+#include "viewport.h"
+#include "worker_pool.h"
+#include "write_ring.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Composites each frame on the CPU into a single pixel buffer and uploads it
+// to a streaming texture, instead of issuing one SDL_RenderCopy per pixel.
+
+// Rows are handed out to compose workers in bands of this many.
+constexpr int COMPOSE_BAND_ROWS = 16;
+
+// With a frame budget set, rows the sort touched are first drawn from one
+// sample per COARSE_STEP x COARSE_STEP block, then refined to full detail
+// REFINE_CHUNK_ROWS at a time until the budget runs out. Rows left coarse
+// carry over to the next frame.
+constexpr int COARSE_STEP = 8;
+constexpr int REFINE_CHUNK_ROWS = 64;
+
+// Source pixels (inclusive) covered by one dirty tile's slots.
+struct TileBounds {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+struct Compositor {
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    // Only set for the reference backend, which draws the image texture
+    // with one SDL_RenderCopy per horizontal span of placed pixels.
+    SDL_Texture* imageTexture = nullptr;
+    int spanCount = 0;
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int dstWidth = 0;
+    int dstHeight = 0;
+    std::vector<Uint32> source;
+    // source downsampled at load, and each window pixel's color for the
+    // current view prefiltered from the matching level.
+    ImagePyramid pyramid;
+    std::vector<Uint32> colors;
+    int colorLevel = 0;
+    std::vector<Uint32> frame;
+    std::vector<int> rowCounts;
+    std::vector<char> dirtyRows;
+    std::vector<char> composeRows;
+    std::vector<int> composedCounts;
+    std::vector<char> staleRows;
+    std::vector<Uint32> coarseRow;
+    int staleCount = 0;
+    int refineCursor = 0;
+    double budgetMs = 0;
+    int composedFrames = 0;
+    int degradedFrames = 0;
+    Viewport view;
+    // Scramble view: every window pixel shows the image pixel of the value
+    // currently in its slot instead of only the placed ones.
+    bool scramble = false;
+    // Set when the view shows consecutive source columns at 1:1, so rows can
+    // be read with the contiguous kernel.
+    bool contiguousColumns = false;
+    std::vector<int> srcColumn;
+    std::vector<int> srcRowOffset;
+    std::vector<int> srcRow;
+    std::vector<int> columnStart;
+    std::vector<int> rowStart;
+    // Where slots are drawn (see index_mapping.h). Row-major needs no tables.
+    // For the curve mappings sampleIndex holds the slot every window pixel
+    // samples, indexSource the image in slot order for the scramble view and
+    // tileBounds the source rectangle each dirty tile covers.
+    IndexMapping mapping = MAPPING_ROW_MAJOR;
+    IndexTables indexTables;
+    std::vector<int> sampleIndex;
+    std::vector<Uint32> indexSource;
+    std::vector<TileBounds> tileBounds;
+    // Window columns [spanFirst, spanLast] of each row that need redrawing;
+    // the rest of the row is kept. Rows are redrawn whole for row-major.
+    std::vector<int> spanFirst;
+    std::vector<int> spanLast;
+    long long composedPixels = 0;
+    CompositeKernels kernels = SCALAR_KERNELS;
+    WorkerPool* pool = nullptr;
+    int counter = 0;
+    int uploadFirst = 0;
+    int uploadLast = -1;
+};
+
+// Points the window at a new part of the image. Only rebuilds the sampling
+// tables and prefiltered colors; the caller recomposites (compose_frame)
+// before the next present.
+inline void compositor_set_view(Compositor& compositor, const Viewport& view) {
+    int dstWidth = compositor.dstWidth;
+    int dstHeight = compositor.dstHeight;
+    compositor.view = view;
+    compositor.colorLevel = prefilter_view(compositor.pyramid, view, dstWidth, dstHeight, compositor.colors);
+
+    // Which source column and row each window pixel shows only changes with
+    // the view, so work it out here and keep the float math out of the
+    // per-frame loops.
+    compositor.srcColumn.resize(dstWidth);
+    for (int dstX = 0; dstX < dstWidth; dstX++) {
+        compositor.srcColumn[dstX] = view_source_column(view, dstX, dstWidth, compositor.srcWidth);
+    }
+    compositor.contiguousColumns = compositor.mapping == MAPPING_ROW_MAJOR;
+    for (int dstX = 1; dstX < dstWidth; dstX++) {
+        compositor.contiguousColumns &= compositor.srcColumn[dstX] == compositor.srcColumn[dstX - 1] + 1;
+    }
+    compositor.srcRow.resize(dstHeight);
+    compositor.srcRowOffset.resize(dstHeight);
+    for (int dstY = 0; dstY < dstHeight; dstY++) {
+        compositor.srcRow[dstY] = view_source_row(view, dstY, dstHeight, compositor.srcHeight);
+        compositor.srcRowOffset[dstY] = compositor.srcWidth * compositor.srcRow[dstY];
+    }
+
+    // And the inverse: source column x covers window columns
+    // [columnStart[x], columnStart[x + 1]), which is empty for columns that
+    // are skipped when downscaling or lie outside the view. Same for rows.
+    compositor.columnStart.assign(compositor.srcWidth + 1, dstWidth);
+    for (int dstX = dstWidth - 1; dstX >= 0; dstX--) {
+        compositor.columnStart[compositor.srcColumn[dstX]] = dstX;
+    }
+    for (int x = compositor.srcWidth - 1; x >= 0; x--) {
+        compositor.columnStart[x] = std::min(compositor.columnStart[x], compositor.columnStart[x + 1]);
+    }
+    compositor.rowStart.assign(compositor.srcHeight + 1, dstHeight);
+    for (int dstY = dstHeight - 1; dstY >= 0; dstY--) {
+        compositor.rowStart[compositor.srcRow[dstY]] = dstY;
+    }
+    for (int y = compositor.srcHeight - 1; y >= 0; y--) {
+        compositor.rowStart[y] = std::min(compositor.rowStart[y], compositor.rowStart[y + 1]);
+    }
+
+    if (compositor.mapping != MAPPING_ROW_MAJOR) {
+        compositor.sampleIndex.resize(dstWidth * dstHeight);
+        for (int dstY = 0; dstY < dstHeight; dstY++) {
+            for (int dstX = 0; dstX < dstWidth; dstX++) {
+                int pixel = compositor.srcRowOffset[dstY] + compositor.srcColumn[dstX];
+                compositor.sampleIndex[dstY * dstWidth + dstX] = compositor.indexTables.pixelIndex[pixel];
+            }
+        }
+    }
+}
+
+// Switches to another slot-to-pixel mapping and rebuilds its tables. Like
+// compositor_set_view, the caller recomposites before the next present. An
+// image too large for a curve falls back to row-major; compositor.mapping
+// says which one is in use.
+inline void compositor_set_mapping(Compositor& compositor, IndexMapping mapping) {
+    compositor.mapping = mapping;
+    compositor.indexTables = IndexTables();
+    compositor.sampleIndex.clear();
+    compositor.indexSource.clear();
+    compositor.tileBounds.clear();
+
+    if (mapping != MAPPING_ROW_MAJOR && !build_index_tables(compositor.indexTables, mapping, compositor.srcWidth, compositor.srcHeight)) {
+        compositor.mapping = MAPPING_ROW_MAJOR;
+    }
+    if (compositor.mapping != MAPPING_ROW_MAJOR) {
+        int pixels = compositor.srcWidth * compositor.srcHeight;
+
+        compositor.indexSource.resize(pixels);
+        compositor.tileBounds.assign((pixels + DIRTY_TILE_SIZE - 1) >> DIRTY_TILE_SHIFT, TileBounds{ compositor.srcWidth, compositor.srcHeight, -1, -1 });
+        for (int index = 0; index < pixels; index++) {
+            int pixel = compositor.indexTables.indexPixel[index];
+            int x = pixel % compositor.srcWidth;
+            int y = pixel / compositor.srcWidth;
+            compositor.indexSource[index] = compositor.source[pixel];
+
+            TileBounds& bounds = compositor.tileBounds[index >> DIRTY_TILE_SHIFT];
+            bounds.left = std::min(bounds.left, x);
+            bounds.top = std::min(bounds.top, y);
+            bounds.right = std::max(bounds.right, x);
+            bounds.bottom = std::max(bounds.bottom, y);
+        }
+    }
+
+    compositor_set_view(compositor, compositor.view);
+}
+
+// Slot shown at window pixel (dstX, dstY).
+inline int sample_slot(const Compositor& compositor, int dstX, int dstY) {
+    if (compositor.mapping != MAPPING_ROW_MAJOR) {
+        return compositor.sampleIndex[dstY * compositor.dstWidth + dstX];
+    }
+    return compositor.srcRowOffset[dstY] + compositor.srcColumn[dstX];
+}
+
+// The image in slot order, which the scramble view indexes by value.
+inline const Uint32* slot_source(const Compositor& compositor) {
+    return compositor.mapping != MAPPING_ROW_MAJOR ? compositor.indexSource.data() : compositor.source.data();
+}
+
+// Outside the scramble view a frame pixel shows a placed element exactly
+// when it is not background.
+inline int count_placed_pixels(const Uint32 pixels[], int count) {
+    int placed = 0;
+    for (int i = 0; i < count; i++) {
+        placed += pixels[i] != BACKGROUND_COLOR;
+    }
+    return placed;
+}
+
+// Prepares everything compose_* needs without touching the renderer.
+inline bool compositor_load(Compositor& compositor, SDL_Surface* surface, int dstWidth, int dstHeight) {
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (converted == nullptr) {
+        return false;
+    }
+
+    compositor.srcWidth = converted->w;
+    compositor.srcHeight = converted->h;
+    compositor.dstWidth = dstWidth;
+    compositor.dstHeight = dstHeight;
+
+    compositor.source.resize(converted->w * converted->h);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < converted->h; y++) {
+        const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels) + y * converted->pitch);
+        for (int x = 0; x < converted->w; x++) {
+            compositor.source[y * converted->w + x] = row[x] | OPAQUE_ALPHA;
+        }
+    }
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+
+    build_pyramid(compositor.pyramid, compositor.source.data(), compositor.srcWidth, compositor.srcHeight, dstWidth, dstHeight);
+    compositor.view = full_view(compositor.srcWidth, compositor.srcHeight);
+    compositor_set_mapping(compositor, compositor.mapping);
+
+    compositor.frame.assign(dstWidth * dstHeight, BACKGROUND_COLOR);
+    compositor.rowCounts.assign(dstHeight, 0);
+    compositor.dirtyRows.assign(compositor.srcHeight, 0);
+    compositor.counter = 0;
+    compositor.uploadFirst = 0;
+    compositor.uploadLast = dstHeight - 1;
+    compositor.composeRows.assign(dstHeight, 0);
+    compositor.composedCounts.assign(dstHeight, 0);
+    compositor.staleRows.assign(dstHeight, 0);
+    compositor.coarseRow.assign(dstWidth, BACKGROUND_COLOR);
+    compositor.spanFirst.assign(dstHeight, dstWidth);
+    compositor.spanLast.assign(dstHeight, -1);
+    compositor.staleCount = 0;
+    compositor.refineCursor = 0;
+    compositor.kernels = select_composite_kernels();
+    return true;
+}
+
+// Splits composition across threads extra worker threads plus the caller. A
+// negative count leaves one core for the sort thread and one for this one.
+// If the pool cannot be started, whatever was started is torn down again and
+// false is returned; the compositor then works on the calling thread alone.
+inline bool compositor_start_workers(Compositor& compositor, int threads) {
+    if (threads < 0) {
+        threads = std::max(SDL_GetCPUCount() - 2, 0);
+    }
+    if (threads == 0) {
+        return true;
+    }
+
+    compositor.pool = new WorkerPool;
+    if (!pool_init(*compositor.pool, threads)) {
+        pool_destroy(*compositor.pool);
+        delete compositor.pool;
+        compositor.pool = nullptr;
+        return false;
+    }
+    return true;
+}
+
+inline bool compositor_init(Compositor& compositor, SDL_Renderer* renderer, SDL_Surface* surface, int dstWidth, int dstHeight, bool renderCopy) {
+    if (!compositor_load(compositor, surface, dstWidth, dstHeight)) {
+        return false;
+    }
+
+    compositor.renderer = renderer;
+    if (renderCopy) {
+        compositor.imageTexture = SDL_CreateTextureFromSurface(renderer, surface);
+        return compositor.imageTexture != nullptr;
+    }
+
+    compositor.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, dstWidth, dstHeight);
+    if (compositor.texture == nullptr) {
+        return false;
+    }
+    SDL_SetTextureBlendMode(compositor.texture, SDL_BLENDMODE_NONE);
+    return true;
+}
+
+// Recomposites the span of one window row and returns how many of the row's
+// pixels show a correctly placed element.
+inline int compose_row(Compositor& compositor, const int arr[], int dstY) {
+    int first = compositor.spanFirst[dstY];
+    int count = compositor.spanLast[dstY] - first + 1;
+    Uint32* out = &compositor.frame[dstY * compositor.dstWidth + first];
+
+    // Pixels outside the span keep their colors and their share of the
+    // count. Spans are always whole rows in the scramble view.
+    int kept = 0;
+    if (count < compositor.dstWidth) {
+        kept = compositor.rowCounts[dstY] - count_placed_pixels(out, count);
+    }
+
+    const int* columns = compositor.srcColumn.data() + first;
+    int rowOffset = compositor.srcRowOffset[dstY];
+    if (compositor.mapping != MAPPING_ROW_MAJOR) {
+        columns = &compositor.sampleIndex[dstY * compositor.dstWidth + first];
+        rowOffset = 0;
+    }
+
+    if (compositor.scramble) {
+        return kept + compositor.kernels.scramble(arr, slot_source(compositor), columns, rowOffset, out, count);
+    }
+    if (compositor.contiguousColumns) {
+        return kept + compositor.kernels.contiguous(arr, compositor.source.data(), rowOffset + compositor.srcColumn[first], out, count);
+    }
+    return kept + compositor.kernels.gather(arr, &compositor.colors[dstY * compositor.dstWidth + first], columns, rowOffset, out, count);
+}
+
+struct ComposeJob {
+    Compositor* compositor;
+    const int* arr;
+    std::atomic<int> nextBand;
+};
+
+// Workers claim bands of rows until none are left. Every row is written by
+// exactly one worker, so the frame and composedCounts need no locking.
+inline void compose_bands(void* context, int /*worker*/) {
+    ComposeJob* job = static_cast<ComposeJob*>(context);
+    Compositor& compositor = *job->compositor;
+
+    while (true) {
+        int first = job->nextBand.fetch_add(1, std::memory_order_relaxed) * COMPOSE_BAND_ROWS;
+        if (first >= compositor.dstHeight) {
+            break;
+        }
+
+        int last = std::min(first + COMPOSE_BAND_ROWS, compositor.dstHeight);
+        for (int dstY = first; dstY < last; dstY++) {
+            if (compositor.composeRows[dstY]) {
+                compositor.composedCounts[dstY] = compose_row(compositor, job->arr, dstY);
+            }
+        }
+    }
+}
+
+// Composites every row flagged in composeRows, then folds the new row counts
+// into the frame total once all bands are done.
+inline int compose_marked_rows(Compositor& compositor, const int arr[]) {
+    ComposeJob job;
+    job.compositor = &compositor;
+    job.arr = arr;
+    job.nextBand = 0;
+
+    if (compositor.pool != nullptr) {
+        pool_run(*compositor.pool, compose_bands, &job);
+    } else {
+        compose_bands(&job, 0);
+    }
+
+    for (int dstY = 0; dstY < compositor.dstHeight; dstY++) {
+        if (compositor.composeRows[dstY]) {
+            compositor.counter += compositor.composedCounts[dstY] - compositor.rowCounts[dstY];
+            compositor.rowCounts[dstY] = compositor.composedCounts[dstY];
+            compositor.composeRows[dstY] = 0;
+            compositor.composedPixels += compositor.spanLast[dstY] - compositor.spanFirst[dstY] + 1;
+            compositor.spanFirst[dstY] = compositor.dstWidth;
+            compositor.spanLast[dstY] = -1;
+
+            compositor.uploadFirst = std::min(compositor.uploadFirst, dstY);
+            compositor.uploadLast = std::max(compositor.uploadLast, dstY);
+        }
+    }
+
+    return compositor.counter;
+}
+
+// Rebuilds the whole frame from the array and returns how many window pixels
+// show a correctly placed element.
+inline int compose_frame(Compositor& compositor, const int arr[]) {
+    std::fill(compositor.composeRows.begin(), compositor.composeRows.end(), 1);
+    std::fill(compositor.spanFirst.begin(), compositor.spanFirst.end(), 0);
+    std::fill(compositor.spanLast.begin(), compositor.spanLast.end(), compositor.dstWidth - 1);
+    std::fill(compositor.staleRows.begin(), compositor.staleRows.end(), 0);
+    compositor.staleCount = 0;
+    return compose_marked_rows(compositor, arr);
+}
+
+// Draws the span of every row flagged in composeRows from one sample per
+// block, using the first flagged row of each band of COARSE_STEP rows as the
+// sample row.
+inline void compose_coarse(Compositor& compositor, const int arr[]) {
+    for (int band = 0; band < compositor.dstHeight; band += COARSE_STEP) {
+        int bandEnd = std::min(band + COARSE_STEP, compositor.dstHeight);
+        int sampleRow = band;
+        while (sampleRow < bandEnd && !compositor.composeRows[sampleRow]) {
+            sampleRow++;
+        }
+        if (sampleRow == bandEnd) {
+            continue;
+        }
+
+        int placed = 0;
+        for (int dstX = 0; dstX < compositor.dstWidth; dstX += COARSE_STEP) {
+            int currentPixel = sample_slot(compositor, dstX, sampleRow);
+            int value = load_element(arr, currentPixel);
+            int blockEnd = std::min(dstX + COARSE_STEP, compositor.dstWidth);
+            Uint32 color = BACKGROUND_COLOR;
+            if (compositor.scramble) {
+                color = slot_source(compositor)[value];
+            } else if (currentPixel == value) {
+                color = compositor.colors[sampleRow * compositor.dstWidth + dstX];
+            }
+            if (currentPixel == value) {
+                placed += blockEnd - dstX;
+            }
+            std::fill(compositor.coarseRow.begin() + dstX, compositor.coarseRow.begin() + blockEnd, color);
+        }
+
+        for (int dstY = sampleRow; dstY < bandEnd; dstY++) {
+            if (compositor.composeRows[dstY]) {
+                int first = compositor.spanFirst[dstY];
+                int count = compositor.spanLast[dstY] - first + 1;
+                Uint32* out = &compositor.frame[dstY * compositor.dstWidth + first];
+
+                int rowPlaced = placed;
+                if (count < compositor.dstWidth) {
+                    rowPlaced = compositor.rowCounts[dstY] - count_placed_pixels(out, count) + count_placed_pixels(&compositor.coarseRow[first], count);
+                }
+                std::copy(compositor.coarseRow.begin() + first, compositor.coarseRow.begin() + first + count, out);
+                compositor.counter += rowPlaced - compositor.rowCounts[dstY];
+                compositor.rowCounts[dstY] = rowPlaced;
+                compositor.composeRows[dstY] = 0;
+
+                compositor.uploadFirst = std::min(compositor.uploadFirst, dstY);
+                compositor.uploadLast = std::max(compositor.uploadLast, dstY);
+            }
+        }
+    }
+}
+
+// Flags the source rows of elements [begin, end) that are inside the view;
+// writes outside it cost nothing to draw. Returns whether any row was flagged.
+inline bool mark_visible_rows(Compositor& compositor, int begin, int end) {
+    int width = compositor.srcWidth;
+    int firstRow = std::max(begin / width, compositor.srcRow.front());
+    int lastRow = std::min((end - 1) / width, compositor.srcRow.back());
+    int firstColumn = compositor.srcColumn.front();
+    int lastColumn = compositor.srcColumn.back();
+
+    bool marked = false;
+    for (int y = firstRow; y <= lastRow; y++) {
+        int rowBegin = std::max(begin - y * width, 0);
+        int rowLast = std::min(end - 1 - y * width, width - 1);
+        if (rowBegin <= lastColumn && rowLast >= firstColumn) {
+            compositor.dirtyRows[y] = 1;
+            marked = true;
+        }
+    }
+    return marked;
+}
+
+// The same for a curve mapping, which draws a tile as a compact block: flags
+// the window rows the tile's bounds cover inside the view and widens their
+// spans to its columns.
+inline bool mark_visible_tile(Compositor& compositor, int tile) {
+    const TileBounds& bounds = compositor.tileBounds[tile];
+    int firstColumn = compositor.columnStart[bounds.left];
+    int endColumn = compositor.columnStart[bounds.right + 1];
+    int firstRow = compositor.rowStart[bounds.top];
+    int endRow = compositor.rowStart[bounds.bottom + 1];
+    if (firstColumn >= endColumn || firstRow >= endRow) {
+        return false;
+    }
+    if (compositor.scramble) {
+        firstColumn = 0;
+        endColumn = compositor.dstWidth;
+    }
+
+    for (int dstY = firstRow; dstY < endRow; dstY++) {
+        compositor.composeRows[dstY] = 1;
+        compositor.spanFirst[dstY] = std::min(compositor.spanFirst[dstY], firstColumn);
+        compositor.spanLast[dstY] = std::max(compositor.spanLast[dstY], endColumn - 1);
+    }
+    return true;
+}
+
+// Recomposites only the window pixels that sample a tile marked since the
+// last call: whole rows for row-major, the tiles' columns for the curves.
+// Without a budget every such row is redrawn at full detail; with one, they
+// are drawn coarse and refined while time remains (see COARSE_STEP).
+// Marks can race with the sort thread's stores, so callers should finish
+// with a compose_frame once sorting is done.
+inline int compose_dirty(Compositor& compositor, const int arr[], DirtyTiles& tiles) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool anyDirty = false;
+
+    for (int word = 0; word < tiles.wordCount; word++) {
+        uint64_t bits = take_dirty_word(tiles, word);
+        while (bits != 0) {
+            int tile = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            if (compositor.mapping != MAPPING_ROW_MAJOR) {
+                anyDirty |= mark_visible_tile(compositor, tile);
+                continue;
+            }
+            int begin = tile << DIRTY_TILE_SHIFT;
+            int end = std::min(begin + DIRTY_TILE_SIZE, tiles.elements);
+            anyDirty |= mark_visible_rows(compositor, begin, end);
+        }
+    }
+
+    if (anyDirty) {
+        for (int dstY = 0; dstY < compositor.dstHeight; dstY++) {
+            if (compositor.dirtyRows[compositor.srcRow[dstY]]) {
+                compositor.composeRows[dstY] = 1;
+                compositor.spanFirst[dstY] = 0;
+                compositor.spanLast[dstY] = compositor.dstWidth - 1;
+            }
+            if (compositor.composeRows[dstY] && !compositor.staleRows[dstY]) {
+                compositor.staleRows[dstY] = 1;
+                compositor.staleCount++;
+            }
+        }
+        std::fill(compositor.dirtyRows.begin(), compositor.dirtyRows.end(), 0);
+
+        if (compositor.budgetMs > 0) {
+            compose_coarse(compositor, arr);
+        }
+    }
+
+    if (compositor.staleCount == 0) {
+        return compositor.counter;
+    }
+    compositor.composedFrames++;
+
+    Uint64 budget = static_cast<Uint64>(compositor.budgetMs * SDL_GetPerformanceFrequency() / 1000.0);
+    while (compositor.staleCount > 0) {
+        int chunk = 0;
+        int dstY = compositor.refineCursor;
+        while (compositor.staleCount > 0 && (compositor.budgetMs <= 0 || chunk < REFINE_CHUNK_ROWS)) {
+            if (compositor.staleRows[dstY]) {
+                compositor.staleRows[dstY] = 0;
+                compositor.staleCount--;
+                compositor.composeRows[dstY] = 1;
+                chunk++;
+            }
+            dstY = (dstY + 1) % compositor.dstHeight;
+        }
+        compositor.refineCursor = dstY;
+        compose_marked_rows(compositor, arr);
+
+        if (compositor.budgetMs > 0 && SDL_GetPerformanceCounter() - start > budget) {
+            break;
+        }
+    }
+
+    if (compositor.staleCount > 0) {
+        compositor.degradedFrames++;
+    }
+
+    return compositor.counter;
+}
+
+// Updates exactly the window pixels that sample the written elements (not
+// used in scramble view, where the frame cannot tell placed pixels apart). An
+// event whose value no longer matches the array was overwritten later, and
+// that newer write is either still queued or was already picked up by a tile
+// rescan, so it is skipped.
+inline int compose_events(Compositor& compositor, const int arr[], WriteRing& ring) {
+    write_ring_drain(ring, [&](const WriteEvent& event) {
+        if (load_element(arr, event.index) != event.value) {
+            return;
+        }
+
+        int pixel = compositor.mapping != MAPPING_ROW_MAJOR ? compositor.indexTables.indexPixel[event.index] : event.index;
+        int x = pixel % compositor.srcWidth;
+        int y = pixel / compositor.srcWidth;
+        int placed = event.value == event.index;
+
+        for (int dstY = compositor.rowStart[y]; dstY < compositor.rowStart[y + 1]; dstY++) {
+            Uint32* row = &compositor.frame[dstY * compositor.dstWidth];
+            const Uint32* colors = &compositor.colors[dstY * compositor.dstWidth];
+            for (int dstX = compositor.columnStart[x]; dstX < compositor.columnStart[x + 1]; dstX++) {
+                int delta = placed - (row[dstX] != BACKGROUND_COLOR);
+                compositor.rowCounts[dstY] += delta;
+                compositor.counter += delta;
+                row[dstX] = placed ? colors[dstX] : BACKGROUND_COLOR;
+            }
+            compositor.uploadFirst = std::min(compositor.uploadFirst, dstY);
+            compositor.uploadLast = std::max(compositor.uploadLast, dstY);
+        }
+    });
+
+    return compositor.counter;
+}
+
+// Run-length merges each row's placed pixels and copies every run from the
+// image texture in one call, recording how many calls the frame took. The
+// frame may have been composited for another view than the current one, so
+// source positions are worked out from the view it was drawn with.
+inline void present_spans(Compositor& compositor, const Uint32* frame, const Viewport& view) {
+    SDL_RenderClear(compositor.renderer);
+
+    int spans = 0;
+    for (int dstY = 0; dstY < compositor.dstHeight; dstY++) {
+        const Uint32* row = &frame[dstY * compositor.dstWidth];
+        int srcY = view_source_row(view, dstY, compositor.dstHeight, compositor.srcHeight);
+        int dstX = 0;
+        while (dstX < compositor.dstWidth) {
+            if (row[dstX] == BACKGROUND_COLOR) {
+                dstX++;
+                continue;
+            }
+
+            int start = dstX;
+            while (dstX < compositor.dstWidth && row[dstX] != BACKGROUND_COLOR) {
+                dstX++;
+            }
+
+            int srcX = view_source_column(view, start, compositor.dstWidth, compositor.srcWidth);
+            int srcLast = view_source_column(view, dstX - 1, compositor.dstWidth, compositor.srcWidth);
+            SDL_Rect srcRect = { srcX, srcY, srcLast - srcX + 1, 1 };
+            SDL_Rect dstRect = { start, dstY, dstX - start, 1 };
+            SDL_RenderCopy(compositor.renderer, compositor.imageTexture, &srcRect, &dstRect);
+            spans++;
+        }
+    }
+    compositor.spanCount = spans;
+
+    SDL_RenderPresent(compositor.renderer);
+}
+
+// True when rows were composited since the last present.
+inline bool frame_changed(const Compositor& compositor) {
+    return compositor.uploadFirst <= compositor.uploadLast;
+}
+
+inline void present_frame(Compositor& compositor) {
+    if (compositor.imageTexture != nullptr) {
+        present_spans(compositor, compositor.frame.data(), compositor.view);
+        compositor.uploadFirst = compositor.dstHeight;
+        compositor.uploadLast = -1;
+        return;
+    }
+
+    if (compositor.uploadFirst <= compositor.uploadLast) {
+        SDL_Rect band = { 0, compositor.uploadFirst, compositor.dstWidth, compositor.uploadLast - compositor.uploadFirst + 1 };
+        SDL_UpdateTexture(compositor.texture, &band, &compositor.frame[compositor.uploadFirst * compositor.dstWidth], compositor.dstWidth * sizeof(Uint32));
+        compositor.uploadFirst = compositor.dstHeight;
+        compositor.uploadLast = -1;
+    }
+    SDL_RenderClear(compositor.renderer);
+    SDL_RenderCopy(compositor.renderer, compositor.texture, nullptr, nullptr);
+    SDL_RenderPresent(compositor.renderer);
+}
+
+// Presents a whole frame composited elsewhere for the given view, e.g. one
+// handed over by the compositor thread. Only touches the renderer and
+// spanCount.
+inline void present_pixels(Compositor& compositor, const Uint32* frame, const Viewport& view) {
+    if (compositor.imageTexture != nullptr) {
+        present_spans(compositor, frame, view);
+        return;
+    }
+
+    SDL_UpdateTexture(compositor.texture, nullptr, frame, compositor.dstWidth * sizeof(Uint32));
+    SDL_RenderClear(compositor.renderer);
+    SDL_RenderCopy(compositor.renderer, compositor.texture, nullptr, nullptr);
+    SDL_RenderPresent(compositor.renderer);
+}
+
+// Shows how much of the image is in place in the window title, plus the
+// draw calls of the last frame for the reference backend.
+inline void show_progress(SDL_Window* window, const Compositor& compositor, int placed, int total) {
+    char title[128];
+    int length;
+    if (compositor.imageTexture != nullptr) {
+        length = SDL_snprintf(title, sizeof(title), "Image Rendering - %.1f%% placed - %d spans", 100.0 * placed / total, compositor.spanCount);
+    } else {
+        length = SDL_snprintf(title, sizeof(title), "Image Rendering - %.1f%% placed", 100.0 * placed / total);
+    }
+    // Sorts that record partition stats also show the level they are at.
+    if (partition_stats_depth() > 0 && length > 0 && length < static_cast<int>(sizeof(title))) {
+        SDL_snprintf(title + length, sizeof(title) - length, " - partition level %d of %d", partitionLevel.load(std::memory_order_relaxed), partition_stats_depth());
+    }
+    SDL_SetWindowTitle(window, title);
+}
+
+inline void compositor_stop_workers(Compositor& compositor) {
+    if (compositor.pool != nullptr) {
+        pool_destroy(*compositor.pool);
+        delete compositor.pool;
+        compositor.pool = nullptr;
+    }
+}
+
+inline void compositor_destroy(Compositor& compositor) {
+    compositor_stop_workers(compositor);
+    if (compositor.texture != nullptr) {
+        SDL_DestroyTexture(compositor.texture);
+        compositor.texture = nullptr;
+    }
+    if (compositor.imageTexture != nullptr) {
+        SDL_DestroyTexture(compositor.imageTexture);
+        compositor.imageTexture = nullptr;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "array_access.h"
+#include <algorithm>
+#include <vector>
+
+inline void swap_arrays(int*& arr, int*& sorted_arr) {
+    int* temp = arr;
+    arr = sorted_arr;
+    sorted_arr = temp;
+}
+
+inline void counting_sort(int arr[], int pixels) {
+    int max_element = *std::max_element(arr, arr + pixels);
+    std::vector<int> count(max_element + 1, 0);
+
+    for (int i = 0; i < pixels; i++)
+        count[arr[i]]++;
+
+    for (int i = 1; i <= max_element; i++)
+        count[i] += count[i - 1];
+
+    std::vector<int> sorted_arr(pixels);
+    for (int i = 0; i < pixels; i++)
+        sorted_arr[i] = arr[i];
+
+    for (int i = pixels - 1; i >= 0; i--) {
+        set_element(arr, count[sorted_arr[i]] - 1, sorted_arr[i]);
+        count[sorted_arr[i]]--;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Bitmap over fixed-size tiles of the array's index space. The sort thread
+// marks each tile it writes into, the compositor takes and clears the marks
+// once per frame and only recomposites what changed since the last one.
+
+constexpr int DIRTY_TILE_SHIFT = 12;
+constexpr int DIRTY_TILE_SIZE = 1 << DIRTY_TILE_SHIFT;
+
+struct DirtyTiles {
+    int elements = 0;
+    int tileCount = 0;
+    int wordCount = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+};
+
+inline void dirty_tiles_init(DirtyTiles& tiles, int elements) {
+    tiles.elements = elements;
+    tiles.tileCount = (elements + DIRTY_TILE_SIZE - 1) >> DIRTY_TILE_SHIFT;
+    tiles.wordCount = (tiles.tileCount + 63) / 64;
+    tiles.words.reset(new std::atomic<uint64_t>[tiles.wordCount]);
+
+    // Everything starts dirty so the first frame composites the whole array.
+    for (int i = 0; i < tiles.wordCount; i++) {
+        int bits = tiles.tileCount - i * 64;
+        tiles.words[i].store(bits >= 64 ? ~0ull : (1ull << bits) - 1, std::memory_order_relaxed);
+    }
+}
+
+inline void mark_tile_dirty(DirtyTiles& tiles, int tile) {
+    std::atomic<uint64_t>& word = tiles.words[tile >> 6];
+    uint64_t bit = 1ull << (tile & 63);
+
+    // Skip the locked RMW while the compositor has not consumed the mark yet;
+    // the sort thread touches the same few tiles over and over.
+    if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+        word.fetch_or(bit, std::memory_order_release);
+    }
+}
+
+inline void mark_dirty(DirtyTiles& tiles, int index) {
+    if (tiles.words) {
+        mark_tile_dirty(tiles, index >> DIRTY_TILE_SHIFT);
+    }
+}
+
+// Marks every tile overlapping [begin, end).
+inline void mark_range_dirty(DirtyTiles& tiles, int begin, int end) {
+    if (!tiles.words || begin >= end) {
+        return;
+    }
+    for (int tile = begin >> DIRTY_TILE_SHIFT; tile <= (end - 1) >> DIRTY_TILE_SHIFT; tile++) {
+        mark_tile_dirty(tiles, tile);
+    }
+}
+
+// Clears one word of the bitmap and returns the tiles that were marked in it.
+inline uint64_t take_dirty_word(DirtyTiles& tiles, int word) {
+    return tiles.words[word].exchange(0, std::memory_order_acquire);
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "frame_pacer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Records the run as uncompressed video. Frames are taken at fixed numbers of
+// array writes rather than on a timer: the sort thread stops at each capture
+// point (see export_capture_point) until the render loop has composited the
+// frame, so a run with a fixed --seed always produces the same file. The
+// render loop copies the frame into one of EXPORT_QUEUE_FRAMES preallocated
+// buffers and a writer thread encodes and writes it, handing the buffer back
+// once done; nothing is allocated per frame.
+//
+// A path ending in .y4m is written as a single YUV4MPEG2 (4:4:4) stream,
+// anything else is used as a prefix for numbered binary PPMs.
+
+constexpr int EXPORT_QUEUE_FRAMES = 4;
+
+struct FrameExporter {
+    std::string path;
+    bool y4m = false;
+    FILE* file = nullptr;
+    int width = 0;
+    int height = 0;
+    int framesWritten = 0;
+    bool failed = false;
+
+    std::vector<std::vector<Uint32>> buffers;
+    std::vector<int> freeBuffers;
+    std::vector<int> queued;
+    std::vector<Uint8> encoded;
+    bool finishing = false;
+    SDL_mutex* mutex = nullptr;
+    SDL_cond* changed = nullptr;
+    SDL_Thread* writer = nullptr;
+
+    long long step = 0;
+    long long nextCapture = 0;
+    std::atomic<bool> stopped{false};
+    SDL_sem* captureRequested = nullptr;
+    SDL_sem* captureDone = nullptr;
+};
+
+inline void encode_ppm(FrameExporter& exporter, const Uint32* frame) {
+    Uint8* out = exporter.encoded.data();
+    for (int i = 0; i < exporter.width * exporter.height; i++) {
+        *out++ = (frame[i] >> 16) & 0xFF;
+        *out++ = (frame[i] >> 8) & 0xFF;
+        *out++ = frame[i] & 0xFF;
+    }
+}
+
+// BT.601 studio range, one plane after the other.
+inline void encode_y4m(FrameExporter& exporter, const Uint32* frame) {
+    int pixels = exporter.width * exporter.height;
+    Uint8* luma = exporter.encoded.data();
+    Uint8* blue = luma + pixels;
+    Uint8* red = blue + pixels;
+    for (int i = 0; i < pixels; i++) {
+        int r = (frame[i] >> 16) & 0xFF;
+        int g = (frame[i] >> 8) & 0xFF;
+        int b = frame[i] & 0xFF;
+        luma[i] = static_cast<Uint8>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        blue[i] = static_cast<Uint8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        red[i] = static_cast<Uint8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+inline bool write_encoded_frame(FrameExporter& exporter, const Uint32* frame) {
+    if (exporter.y4m) {
+        encode_y4m(exporter, frame);
+        std::fputs("FRAME\n", exporter.file);
+        return std::fwrite(exporter.encoded.data(), 1, exporter.encoded.size(), exporter.file) == exporter.encoded.size();
+    }
+
+    char name[32];
+    SDL_snprintf(name, sizeof(name), "%06d.ppm", exporter.framesWritten);
+    FILE* file = std::fopen((exporter.path + name).c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    encode_ppm(exporter, frame);
+    std::fprintf(file, "P6\n%d %d\n255\n", exporter.width, exporter.height);
+    bool written = std::fwrite(exporter.encoded.data(), 1, exporter.encoded.size(), file) == exporter.encoded.size();
+    return std::fclose(file) == 0 && written;
+}
+
+inline int export_writer(void* data) {
+    FrameExporter& exporter = *static_cast<FrameExporter*>(data);
+
+    SDL_LockMutex(exporter.mutex);
+    while (true) {
+        while (exporter.queued.empty() && !exporter.finishing) {
+            SDL_CondWait(exporter.changed, exporter.mutex);
+        }
+        if (exporter.queued.empty()) {
+            break;
+        }
+        int buffer = exporter.queued.front();
+        exporter.queued.erase(exporter.queued.begin());
+        SDL_UnlockMutex(exporter.mutex);
+
+        if (!exporter.failed) {
+            if (write_encoded_frame(exporter, exporter.buffers[buffer].data())) {
+                exporter.framesWritten++;
+            } else {
+                std::cerr << "Failed to write frame " << exporter.framesWritten << " to " << exporter.path << std::endl;
+                exporter.failed = true;
+            }
+        }
+
+        SDL_LockMutex(exporter.mutex);
+        exporter.freeBuffers.push_back(buffer);
+        SDL_CondBroadcast(exporter.changed);
+    }
+    SDL_UnlockMutex(exporter.mutex);
+
+    return 0;
+}
+
+inline bool exporter_init(FrameExporter& exporter, const std::string& path, int width, int height, long long step) {
+    exporter.path = path;
+    exporter.y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    exporter.width = width;
+    exporter.height = height;
+    exporter.step = step;
+    exporter.nextCapture = step;
+
+    if (exporter.y4m) {
+        exporter.file = std::fopen(path.c_str(), "wb");
+        if (exporter.file == nullptr) {
+            return false;
+        }
+        std::fprintf(exporter.file, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C444\n", width, height);
+    }
+
+    exporter.encoded.resize(static_cast<size_t>(width) * height * 3);
+    exporter.buffers.assign(EXPORT_QUEUE_FRAMES, std::vector<Uint32>(static_cast<size_t>(width) * height));
+    for (int i = 0; i < EXPORT_QUEUE_FRAMES; i++) {
+        exporter.freeBuffers.push_back(i);
+    }
+    exporter.queued.reserve(EXPORT_QUEUE_FRAMES);
+
+    exporter.mutex = SDL_CreateMutex();
+    exporter.changed = SDL_CreateCond();
+    exporter.captureRequested = SDL_CreateSemaphore(0);
+    exporter.captureDone = SDL_CreateSemaphore(0);
+    if (exporter.mutex == nullptr || exporter.changed == nullptr || exporter.captureRequested == nullptr || exporter.captureDone == nullptr) {
+        return false;
+    }
+
+    exporter.writer = SDL_CreateThread(export_writer, "export", &exporter);
+    return exporter.writer != nullptr;
+}
+
+// Render loop side: copies the frame into a free buffer, waiting for the
+// writer if all of them are queued, and queues it.
+inline void export_frame(FrameExporter& exporter, const std::vector<Uint32>& frame) {
+    SDL_LockMutex(exporter.mutex);
+    while (exporter.freeBuffers.empty()) {
+        SDL_CondWait(exporter.changed, exporter.mutex);
+    }
+    int buffer = exporter.freeBuffers.back();
+    exporter.freeBuffers.pop_back();
+    SDL_UnlockMutex(exporter.mutex);
+
+    std::copy(frame.begin(), frame.end(), exporter.buffers[buffer].begin());
+
+    SDL_LockMutex(exporter.mutex);
+    exporter.queued.push_back(buffer);
+    SDL_CondBroadcast(exporter.changed);
+    SDL_UnlockMutex(exporter.mutex);
+}
+
+// Sort thread side, called with the running write count after every batch
+// of writes. Blocks at each capture point until the frame has been taken.
+// Only one thread may write while exporting.
+inline void export_capture_point(FrameExporter& exporter, long long writes) {
+    if (writes < exporter.nextCapture || exporter.stopped.load(std::memory_order_acquire)) {
+        return;
+    }
+    while (exporter.nextCapture <= writes) {
+        exporter.nextCapture += exporter.step;
+    }
+    flushDeadline.store(exporter.nextCapture, std::memory_order_relaxed);
+
+    SDL_SemPost(exporter.captureRequested);
+    pacer_wake();
+    SDL_SemWait(exporter.captureDone);
+}
+
+inline FrameExporter* activeExporter = nullptr;
+
+inline void export_on_flush(long long writes) {
+    export_capture_point(*activeExporter, writes);
+}
+
+// Opens the output and starts the writer, then hooks the exporter into the
+// write counter so the sort thread starts stopping at capture points.
+inline bool exporter_start(FrameExporter& exporter, const std::string& path, int width, int height, long long step) {
+    if (!exporter_init(exporter, path, width, height, step)) {
+        return false;
+    }
+    activeExporter = &exporter;
+    flushDeadline.store(exporter.nextCapture, std::memory_order_relaxed);
+    return add_flush_hook(export_on_flush);
+}
+
+// Render loop side: true when the sort thread is parked at a capture point.
+// The caller composites, calls export_frame and then export_release.
+inline bool export_pending(FrameExporter& exporter) {
+    return SDL_SemTryWait(exporter.captureRequested) == 0;
+}
+
+inline void export_release(FrameExporter& exporter) {
+    SDL_SemPost(exporter.captureDone);
+}
+
+// Stops taking captures, lets a parked sort thread go and waits for every
+// queued frame to be written. The extra post also covers a sort thread that
+// checked the flag just before it was set and is about to park. The capture
+// semaphores are left alive because that thread may still be running when
+// the user closes the window early.
+inline void exporter_finish(FrameExporter& exporter) {
+    exporter.stopped.store(true, std::memory_order_release);
+    if (exporter.captureDone != nullptr) {
+        export_release(exporter);
+    }
+
+    if (exporter.writer != nullptr) {
+        SDL_LockMutex(exporter.mutex);
+        exporter.finishing = true;
+        SDL_CondBroadcast(exporter.changed);
+        SDL_UnlockMutex(exporter.mutex);
+        SDL_WaitThread(exporter.writer, nullptr);
+        exporter.writer = nullptr;
+    }
+
+    if (exporter.file != nullptr) {
+        std::fclose(exporter.file);
+        exporter.file = nullptr;
+    }
+    if (exporter.changed != nullptr) {
+        SDL_DestroyCond(exporter.changed);
+    }
+    if (exporter.mutex != nullptr) {
+        SDL_DestroyMutex(exporter.mutex);
+    }
+    exporter.changed = nullptr;
+    exporter.mutex = nullptr;
+}
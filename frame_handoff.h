@@ -0,0 +1,84 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "viewport.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Lock-free triple buffer between the compositor thread and the thread that
+// owns the window. The compositor fills its back buffer and swaps it with the
+// middle one; the presenter swaps its front buffer with the middle one when a
+// fresh frame is there. Neither side ever waits for the other: a frame the
+// presenter had no time to show is simply replaced by the next one.
+
+constexpr int HANDOFF_FRESH = 4;
+constexpr int HANDOFF_INDEX = 3;
+
+struct FrameHandoff {
+    std::vector<Uint32> buffers[3];
+    Viewport views[3];
+    std::atomic<int> middle{1};
+    int back = 0;
+    int front = 2;
+    int published = 0;
+    int presented = 0;
+    // SDL event pushed after each publish so the window thread can sleep in
+    // SDL_WaitEvent; at most one is queued at once.
+    Uint32 readyEvent = static_cast<Uint32>(-1);
+    std::atomic<bool> readyPending{false};
+};
+
+inline bool handoff_init(FrameHandoff& handoff, int pixels) {
+    for (std::vector<Uint32>& buffer : handoff.buffers) {
+        buffer.assign(pixels, 0);
+    }
+    handoff.readyEvent = SDL_RegisterEvents(1);
+    return handoff.readyEvent != static_cast<Uint32>(-1);
+}
+
+// Compositor side: tells the window thread to look for a new frame (or that
+// the compositor has stopped).
+inline void handoff_notify(FrameHandoff& handoff) {
+    if (handoff.readyPending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = handoff.readyEvent;
+    SDL_PushEvent(&event);
+}
+
+// Compositor side: copies the finished frame, and the view it shows, into
+// the back buffer and publishes it.
+inline void handoff_publish(FrameHandoff& handoff, const std::vector<Uint32>& frame, const Viewport& view) {
+    std::copy(frame.begin(), frame.end(), handoff.buffers[handoff.back].begin());
+    handoff.views[handoff.back] = view;
+    handoff.back = handoff.middle.exchange(handoff.back | HANDOFF_FRESH, std::memory_order_acq_rel) & HANDOFF_INDEX;
+    handoff.published++;
+    handoff_notify(handoff);
+}
+
+// Window side: true when an event is the compositor's notification.
+inline bool handoff_ready_event(FrameHandoff& handoff, const SDL_Event& event) {
+    if (event.type != handoff.readyEvent) {
+        return false;
+    }
+    handoff.readyPending.store(false, std::memory_order_release);
+    return true;
+}
+
+// Window side: takes the newest published frame, if there is one the window
+// has not shown yet. The frame stays valid until the next call.
+inline const Uint32* handoff_take(FrameHandoff& handoff) {
+    if (!(handoff.middle.load(std::memory_order_relaxed) & HANDOFF_FRESH)) {
+        return nullptr;
+    }
+    handoff.front = handoff.middle.exchange(handoff.front, std::memory_order_acq_rel) & HANDOFF_INDEX;
+    handoff.presented++;
+    return handoff.buffers[handoff.front].data();
+}
+
+inline const Viewport& handoff_view(const FrameHandoff& handoff) {
+    return handoff.views[handoff.front];
+}
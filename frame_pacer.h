@@ -0,0 +1,103 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "array_access.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+// Paces the compositor instead of letting it spin. The compositing thread
+// sleeps until the next frame deadline and composites at most once per
+// interval. When a frame found nothing to draw it goes idle and sleeps until
+// the sort thread signals new writes (from its placed count flush) or until
+// PACER_IDLE_WAIT_MS has passed, whichever comes first.
+
+constexpr Uint32 PACER_IDLE_WAIT_MS = 100;
+
+struct FramePacer {
+    Uint64 interval = 0;
+    Uint64 nextFrame = 0;
+    Uint64 started = 0;
+    Uint64 slept = 0;
+    int frames = 0;
+    int idleFrames = 0;
+    std::atomic<bool> idle{false};
+    // Posted to cut a sleep short; at most one post is outstanding at once.
+    SDL_sem* wake = nullptr;
+    std::atomic<bool> wakePending{false};
+};
+
+inline FramePacer* activePacer = nullptr;
+
+// Safe to call from any thread.
+inline void pacer_wake() {
+    FramePacer* pacer = activePacer;
+    if (pacer == nullptr || pacer->wakePending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    SDL_SemPost(pacer->wake);
+}
+
+inline void pacer_on_flush(long long) {
+    if (activePacer->idle.load(std::memory_order_relaxed)) {
+        pacer_wake();
+    }
+}
+
+inline bool pacer_start(FramePacer& pacer, double intervalMs) {
+    pacer.wake = SDL_CreateSemaphore(0);
+    if (pacer.wake == nullptr) {
+        return false;
+    }
+
+    pacer.interval = static_cast<Uint64>(intervalMs * SDL_GetPerformanceFrequency() / 1000.0);
+    pacer.started = SDL_GetPerformanceCounter();
+    pacer.nextFrame = pacer.started;
+    activePacer = &pacer;
+    return add_flush_hook(pacer_on_flush);
+}
+
+inline bool pacer_frame_due(const FramePacer& pacer) {
+    return pacer.idle.load(std::memory_order_relaxed) || SDL_GetPerformanceCounter() >= pacer.nextFrame;
+}
+
+// Call after every due frame; drew says whether anything changed.
+inline void pacer_frame_done(FramePacer& pacer, bool drew) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (drew) {
+        pacer.frames++;
+    } else {
+        pacer.idleFrames++;
+    }
+    pacer.idle.store(!drew, std::memory_order_relaxed);
+
+    // A late frame moves the schedule instead of trying to catch up.
+    pacer.nextFrame = std::max(pacer.nextFrame + pacer.interval, now);
+}
+
+// Sleeps until the next frame is due, pacer_wake is called or, while idle,
+// the idle timeout passes (an idle loop always has a frame due, so it looks
+// again even without a signal and notices when the sort has finished).
+inline void pacer_wait(FramePacer& pacer) {
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 deadline = pacer.idle.load(std::memory_order_relaxed) ? start + PACER_IDLE_WAIT_MS * frequency / 1000 : pacer.nextFrame;
+
+    if (start < deadline) {
+        Uint32 timeout = static_cast<Uint32>((deadline - start) * 1000 / frequency);
+        if (SDL_SemWaitTimeout(pacer.wake, std::max<Uint32>(timeout, 1)) == 0) {
+            pacer.wakePending.store(false, std::memory_order_release);
+        }
+    }
+
+    pacer.slept += SDL_GetPerformanceCounter() - start;
+}
+
+inline void print_pacer_stats(const FramePacer& pacer) {
+    double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    double elapsed = (SDL_GetPerformanceCounter() - pacer.started) / frequency;
+    double slept = pacer.slept / frequency;
+    std::cout << "Frames drawn: " << pacer.frames << " in " << elapsed << "s (" << (elapsed > 0 ? pacer.frames / elapsed : 0) << " fps), "
+              << pacer.idleFrames << " checks with nothing to draw" << std::endl;
+    std::cout << "Compositor asleep for " << slept << "s (" << (elapsed > 0 ? 100 * slept / elapsed : 0) << "% of the run)" << std::endl;
+}
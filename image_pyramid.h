@@ -0,0 +1,137 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "viewport.h"
+#include <algorithm>
+#include <vector>
+
+// Downsampled copies of the image, built once at load, and the image
+// prefiltered to exactly the window's pixels for the current view. The
+// compositor reads each window pixel's color from the prefiltered copy in
+// the same order it writes the frame, instead of gathering single pixels
+// from the full-resolution image, so a frame's color reads are sequential
+// and only as large as the window. The pyramid keeps rebuilding that copy
+// cheap at any zoom: it always averages at most 3x3 pixels of the level that
+// matches the view's scale.
+
+struct ImageLevel {
+    int width = 0;
+    int height = 0;
+    const Uint32* pixels = nullptr;
+};
+
+struct ImagePyramid {
+    // Level k is the image shrunk by 2^k with a 2x2 box filter. Level 0 is
+    // the image itself, which is not copied; storage holds levels 1 and up.
+    std::vector<ImageLevel> levels;
+    std::vector<std::vector<Uint32>> storage;
+};
+
+// Per-channel running average of ARGB pixels.
+struct PixelAverage {
+    Uint32 sums[4] = { 0, 0, 0, 0 };
+    Uint32 count = 0;
+};
+
+inline void add_pixel(PixelAverage& average, Uint32 pixel) {
+    for (int channel = 0; channel < 4; channel++) {
+        average.sums[channel] += (pixel >> (channel * 8)) & 0xFF;
+    }
+    average.count++;
+}
+
+inline Uint32 average_color(const PixelAverage& average) {
+    Uint32 color = 0;
+    for (int channel = 0; channel < 4; channel++) {
+        color |= ((average.sums[channel] + average.count / 2) / average.count) << (channel * 8);
+    }
+    return color;
+}
+
+// Builds levels until the next one would be smaller than the window in
+// either direction; views never shrink the image further than that.
+inline void build_pyramid(ImagePyramid& pyramid, const Uint32* image, int width, int height, int dstWidth, int dstHeight) {
+    pyramid.levels.assign(1, ImageLevel{ width, height, image });
+    pyramid.storage.clear();
+
+    while (pyramid.levels.back().width / 2 >= dstWidth && pyramid.levels.back().height / 2 >= dstHeight) {
+        ImageLevel previous = pyramid.levels.back();
+        ImageLevel level = { previous.width / 2, previous.height / 2, nullptr };
+        pyramid.storage.emplace_back(static_cast<size_t>(level.width) * level.height);
+        std::vector<Uint32>& pixels = pyramid.storage.back();
+
+        for (int y = 0; y < level.height; y++) {
+            const Uint32* top = previous.pixels + 2 * y * previous.width;
+            const Uint32* bottom = top + previous.width;
+            for (int x = 0; x < level.width; x++) {
+                PixelAverage average;
+                add_pixel(average, top[2 * x]);
+                add_pixel(average, top[2 * x + 1]);
+                add_pixel(average, bottom[2 * x]);
+                add_pixel(average, bottom[2 * x + 1]);
+                pixels[y * level.width + x] = average_color(average);
+            }
+        }
+
+        level.pixels = pixels.data();
+        pyramid.levels.push_back(level);
+    }
+}
+
+// Pyramid level whose pixels are closest to, but not smaller than, one
+// window pixel for this view.
+inline int pyramid_level_for_view(const ImagePyramid& pyramid, const Viewport& view, int dstWidth, int dstHeight) {
+    float scale = std::min(view.width / dstWidth, view.height / dstHeight);
+    int level = 0;
+    while (level + 1 < static_cast<int>(pyramid.levels.size()) && scale >= static_cast<float>(2 << level)) {
+        level++;
+    }
+    return level;
+}
+
+// First and one-past-last level pixel covered by window column (or row)
+// dst, from the level 0 positions the compositor samples.
+inline void footprint(int start0, int end0, int level, int size, int& first, int& last) {
+    first = std::min(start0 >> level, size - 1);
+    last = std::min(std::max(first + 1, (end0 + (1 << level) - 1) >> level), size);
+}
+
+// Fills colors (dstWidth x dstHeight) with the box-filtered image for view
+// and returns the level it was read from. When the view magnifies, every
+// window pixel covers less than one image pixel and simply gets that pixel.
+inline int prefilter_view(const ImagePyramid& pyramid, const Viewport& view, int dstWidth, int dstHeight, std::vector<Uint32>& colors) {
+    int level = pyramid_level_for_view(pyramid, view, dstWidth, dstHeight);
+    const ImageLevel& image = pyramid.levels[level];
+    const ImageLevel& full = pyramid.levels[0];
+
+    std::vector<int> columnFirst(dstWidth);
+    std::vector<int> columnLast(dstWidth);
+    for (int dstX = 0; dstX < dstWidth; dstX++) {
+        int start = view_source_column(view, dstX, dstWidth, full.width);
+        int end = dstX + 1 < dstWidth ? view_source_column(view, dstX + 1, dstWidth, full.width) : static_cast<int>(view.x + view.width);
+        footprint(start, end, level, image.width, columnFirst[dstX], columnLast[dstX]);
+    }
+
+    colors.resize(static_cast<size_t>(dstWidth) * dstHeight);
+    for (int dstY = 0; dstY < dstHeight; dstY++) {
+        int start = view_source_row(view, dstY, dstHeight, full.height);
+        int end = dstY + 1 < dstHeight ? view_source_row(view, dstY + 1, dstHeight, full.height) : static_cast<int>(view.y + view.height);
+        int rowFirst = 0;
+        int rowLast = 0;
+        footprint(start, end, level, image.height, rowFirst, rowLast);
+
+        Uint32* out = &colors[dstY * dstWidth];
+        for (int dstX = 0; dstX < dstWidth; dstX++) {
+            PixelAverage average;
+            for (int y = rowFirst; y < rowLast; y++) {
+                const Uint32* row = image.pixels + y * image.width;
+                for (int x = columnFirst[dstX]; x < columnLast[dstX]; x++) {
+                    add_pixel(average, row[x]);
+                }
+            }
+            out[dstX] = average_color(average);
+        }
+    }
+
+    return level;
+}
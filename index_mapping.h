@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && !defined(SHARED_ARRAY_SCALAR_ONLY)
+#define MAPPING_X86 1
+#include <immintrin.h>
+#endif
+
+// Where each array slot is drawn. Row-major puts slot i at pixel
+// (i % width, i / width), so a run of consecutive slots is a thin horizontal
+// stripe. Morton (Z-order) and Hilbert order put it in a compact block
+// instead, which keeps the window area a sorting pass dirties small. Only the
+// drawing changes: the sorts still sort slots 0 .. width * height - 1.
+//
+// The curves are laid over the smallest power-of-two square that covers the
+// image and numbered in curve order, skipping cells outside the image, so
+// every slot has exactly one pixel for any image size. Both directions are
+// kept as tables, built once at load. Curve codes are 32 bits, so the square
+// can be at most CURVE_MAX_SIDE wide.
+
+constexpr uint64_t CURVE_MAX_SIDE = 1 << 16;
+
+enum IndexMapping {
+    MAPPING_ROW_MAJOR,
+    MAPPING_MORTON,
+    MAPPING_HILBERT
+};
+
+inline const char* mapping_name(IndexMapping mapping) {
+    switch (mapping) {
+    case MAPPING_MORTON:
+        return "morton";
+    case MAPPING_HILBERT:
+        return "hilbert";
+    default:
+        return "row-major";
+    }
+}
+
+// Returns false for names that are not a mapping.
+inline bool parse_mapping(const char* name, IndexMapping& mapping) {
+    for (IndexMapping candidate : { MAPPING_ROW_MAJOR, MAPPING_MORTON, MAPPING_HILBERT }) {
+        if (std::strcmp(name, mapping_name(candidate)) == 0) {
+            mapping = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct IndexTables {
+    // pixelIndex[x + width * y] is the slot drawn at (x, y); indexPixel is
+    // the inverse.
+    std::vector<int> pixelIndex;
+    std::vector<int> indexPixel;
+    int next = 0;
+};
+
+inline void add_curve_cell(IndexTables& tables, int x, int y, int width, int height) {
+    if (x < width && y < height) {
+        int pixel = x + width * y;
+        tables.pixelIndex[pixel] = tables.next;
+        tables.indexPixel[tables.next] = pixel;
+        tables.next++;
+    }
+}
+
+// Byte b of a Morton code holds four bits of x (even positions) and four of
+// y (odd positions); entry b packs them as x in the low nibble, y in the high.
+inline const std::vector<uint8_t> MORTON_COMPACT = [] {
+    std::vector<uint8_t> table(256);
+    for (int b = 0; b < 256; b++) {
+        int x = 0;
+        int y = 0;
+        for (int bit = 0; bit < 4; bit++) {
+            x |= ((b >> (2 * bit)) & 1) << bit;
+            y |= ((b >> (2 * bit + 1)) & 1) << bit;
+        }
+        table[b] = static_cast<uint8_t>(x | y << 4);
+    }
+    return table;
+}();
+
+inline void fill_morton_table(IndexTables& tables, int side, int width, int height) {
+    uint64_t cells = static_cast<uint64_t>(side) * side;
+    for (uint64_t code = 0; code < cells; code++) {
+        int x = 0;
+        int y = 0;
+        for (int byte = 0; byte < 4; byte++) {
+            uint8_t packed = MORTON_COMPACT[(code >> (8 * byte)) & 0xFF];
+            x |= (packed & 0xF) << (4 * byte);
+            y |= (packed >> 4) << (4 * byte);
+        }
+        add_curve_cell(tables, x, y, width, height);
+    }
+}
+
+#ifdef MAPPING_X86
+// pext pulls the even and odd bits of the code apart in one instruction each.
+__attribute__((target("bmi2")))
+inline void fill_morton_bmi2(IndexTables& tables, int side, int width, int height) {
+    uint64_t cells = static_cast<uint64_t>(side) * side;
+    for (uint64_t code = 0; code < cells; code++) {
+        int x = static_cast<int>(_pext_u32(static_cast<uint32_t>(code), 0x55555555u));
+        int y = static_cast<int>(_pext_u32(static_cast<uint32_t>(code), 0xAAAAAAAAu));
+        add_curve_cell(tables, x, y, width, height);
+    }
+}
+#endif
+
+// A Hilbert curve is read two bits (one quadrant) at a time from the top.
+// Each quadrant holds a smaller curve that is transposed (first quadrant),
+// anti-transposed (last) or unchanged, so the orientation so far is one of
+// four and composing two is an xor: 0 unchanged, 1 transposed, 2
+// anti-transposed, 3 turned half way. HILBERT_STEPS[orientation][byte] does
+// four quadrants at once: x bits in the low nibble, y bits in the next and
+// the orientation after them above.
+inline const std::vector<uint16_t> HILBERT_STEPS = [] {
+    const int quadrantX[4] = { 0, 0, 1, 1 };
+    const int quadrantY[4] = { 0, 1, 1, 0 };
+    const int quadrantTurn[4] = { 1, 0, 0, 2 };
+
+    std::vector<uint16_t> table(4 * 256);
+    for (int orientation = 0; orientation < 4; orientation++) {
+        for (int byte = 0; byte < 256; byte++) {
+            int turn = orientation;
+            int x = 0;
+            int y = 0;
+            for (int digit = 3; digit >= 0; digit--) {
+                int quadrant = (byte >> (2 * digit)) & 3;
+                int qx = quadrantX[quadrant];
+                int qy = quadrantY[quadrant];
+                if (turn & 1) {
+                    std::swap(qx, qy);
+                }
+                if (turn & 2) {
+                    int flipped = 1 - qy;
+                    qy = 1 - qx;
+                    qx = flipped;
+                }
+                x |= qx << digit;
+                y |= qy << digit;
+                turn ^= quadrantTurn[quadrant];
+            }
+            table[orientation * 256 + byte] = static_cast<uint16_t>(x | y << 4 | turn << 8);
+        }
+    }
+    return table;
+}();
+
+inline void fill_hilbert(IndexTables& tables, int side, int width, int height) {
+    int order = 0;
+    while ((1 << order) < side) {
+        order++;
+    }
+    // Codes are read as 16 quadrants; each leading zero quadrant transposes,
+    // so start out turned such that the real ones begin unchanged.
+    int start = (16 - order) & 1;
+
+    uint64_t cells = static_cast<uint64_t>(side) * side;
+    for (uint64_t d = 0; d < cells; d++) {
+        int turn = start;
+        int x = 0;
+        int y = 0;
+        for (int byte = 3; byte >= 0; byte--) {
+            uint16_t step = HILBERT_STEPS[turn * 256 + ((d >> (8 * byte)) & 0xFF)];
+            x |= (step & 0xF) << (4 * byte);
+            y |= ((step >> 4) & 0xF) << (4 * byte);
+            turn = step >> 8;
+        }
+        add_curve_cell(tables, x, y, width, height);
+    }
+}
+
+// Builds both tables for a curve mapping. Row-major needs none; callers
+// leave the tables empty for it. Returns false, leaving the tables empty, for
+// images too large for the curve codes.
+inline bool build_index_tables(IndexTables& tables, IndexMapping mapping, int width, int height) {
+    uint64_t side = 1;
+    while (side < static_cast<uint64_t>(width) || side < static_cast<uint64_t>(height)) {
+        side *= 2;
+    }
+    if (side > CURVE_MAX_SIDE) {
+        return false;
+    }
+
+    tables.pixelIndex.assign(static_cast<size_t>(width) * height, 0);
+    tables.indexPixel.assign(static_cast<size_t>(width) * height, 0);
+    tables.next = 0;
+
+    if (mapping == MAPPING_HILBERT) {
+        fill_hilbert(tables, static_cast<int>(side), width, height);
+        return true;
+    }
+#ifdef MAPPING_X86
+    if (__builtin_cpu_supports("bmi2")) {
+        fill_morton_bmi2(tables, static_cast<int>(side), width, height);
+        return true;
+    }
+#endif
+    fill_morton_table(tables, static_cast<int>(side), width, height);
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "array_access.h"
+
+inline void insertion_sort(int arr[], int size) {
+    for (int i = 1; i < size; ++i) {
+        int key = arr[i];
+        int j = i - 1;
+
+        while (j >= 0 && arr[j] > key) {
+            set_element(arr, j + 1, arr[j]);
+            --j;
+        }
+
+        set_element(arr, j + 1, key);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "array_access.h"
+
+inline void merge(int arr[], int left, int mid, int right) {
+    int n1 = mid - left + 1;
+    int n2 = right - mid;
+
+    int *L = new int[n1];
+    int *R = new int[n2];
+
+    for (int i = 0; i < n1; i++)
+        L[i] = arr[left + i];
+    for (int j = 0; j < n2; j++)
+        R[j] = arr[mid + 1 + j];
+
+    int i = 0, j = 0, k = left;
+    while (i < n1 && j < n2) {
+        if (L[i] <= R[j]) {
+            set_element(arr, k, L[i]);
+            i++;
+        } else {
+            set_element(arr, k, R[j]);
+            j++;
+        }
+        k++;
+    }
+
+    while (i < n1) {
+        set_element(arr, k, L[i]);
+        i++;
+        k++;
+    }
+
+    while (j < n2) {
+        set_element(arr, k, R[j]);
+        j++;
+        k++;
+    }
+
+    delete[] L;
+    delete[] R;
+}
+
+inline void merge_sort(int arr[], int low, int high) {
+    if (low < high) {
+        int mid = low + (high - low) / 2;
+
+        merge_sort(arr, low, mid);
+        merge_sort(arr, mid + 1, high);
+
+        merge(arr, low, mid, high);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "index_mapping.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Command line switches of the sort driver.
+struct Options {
+    std::string algorithm = "quicksort";
+    bool writeEvents = false;
+    int composeThreads = -1;
+    int sortThreads = 0;
+    bool renderCopy = false;
+    bool scramble = false;
+    double frameBudget = -1;
+    bool headless = false;
+    unsigned seed = 0;
+    std::string exportPath;
+    long long exportEvery = 1 << 20;
+    IndexMapping mapping = MAPPING_ROW_MAJOR;
+};
+
+inline Options parse_options(int argc, char* argv[]) {
+    Options options;
+
+    const char* headless = std::getenv("SORT_HEADLESS");
+    if (headless != nullptr && headless[0] != '\0' && std::strcmp(headless, "0") != 0) {
+        options.headless = true;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--algorithm") == 0 && i + 1 < argc) {
+            options.algorithm = argv[++i];
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(argv[i], "--events") == 0) {
+            options.writeEvents = true;
+        } else if (std::strcmp(argv[i], "--render-copy") == 0) {
+            options.renderCopy = true;
+        } else if (std::strcmp(argv[i], "--scramble") == 0) {
+            options.scramble = true;
+        } else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            options.frameBudget = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--compose-threads") == 0 && i + 1 < argc) {
+            options.composeThreads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sort-threads") == 0 && i + 1 < argc) {
+            options.sortThreads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            options.exportPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--export-every") == 0 && i + 1 < argc) {
+            options.exportEvery = std::max(1LL, std::atoll(argv[++i]));
+        } else if (std::strcmp(argv[i], "--mapping") == 0 && i + 1 < argc) {
+            if (!parse_mapping(argv[++i], options.mapping)) {
+                std::cerr << "Unknown mapping " << argv[i] << ", using row-major" << std::endl;
+            }
+        } else {
+            std::cerr << "Ignoring unknown option: " << argv[i] << std::endl;
+        }
+    }
+
+    // The scramble view draws every pixel, so neither the span backend nor
+    // per-write events (which tell placed pixels apart by the background)
+    // can follow it.
+    if (options.scramble && (options.renderCopy || options.writeEvents)) {
+        std::cerr << "--scramble ignores --render-copy and --events" << std::endl;
+        options.renderCopy = false;
+        options.writeEvents = false;
+    }
+
+    return options;
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "quicksort.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+// Quicksort on several SDL threads. Each split keeps partitioning its smaller
+// side and pushes the larger one onto the splitting worker's own deque as a
+// task. Workers take their newest task first and, when they run out, steal the
+// oldest (and so largest) task of another worker. Ranges of up to
+// PARALLEL_GRAIN elements, and anything below the introsort depth limit,
+// are sorted serially by introsort_loop. Partitioning is quicksort's
+// (choose_pivot, lomuto_partition), so it can be compared with the serial
+// kernels directly, except that ranges of more than
+// PARALLEL_PARTITION_THRESHOLD elements are partitioned by every idle worker
+// together (parallel_partition): otherwise the first splits are one serial
+// pass over the whole array after another, and the other workers wait.
+//
+// Writes come from several threads at once, so the sort driver turns off the
+// features that need a single writer (write events, frame export).
+
+constexpr int PARALLEL_GRAIN = 1 << 14;
+
+// Below this a range is partitioned by its own worker; sharing it costs a
+// trip through the job list and a second pass over the misplaced elements.
+constexpr int PARALLEL_PARTITION_THRESHOLD = 1 << 18;
+
+// A worker with nothing to do retries this many times, yielding in between,
+// before it starts napping for a millisecond at a time.
+constexpr int PARALLEL_IDLE_SPINS = 64;
+
+// Threads to sort with; 0 uses one per core.
+inline int sortThreads = 0;
+
+struct SortTask {
+    int low;
+    int high;
+    int depthLimit;
+};
+
+struct StealingDeque {
+    SDL_SpinLock lock = 0;
+    std::deque<SortTask> tasks;
+};
+
+// One range being partitioned by several workers. Phase 1 splits it into
+// chunks of PARALLEL_GRAIN elements that are each partitioned on their own.
+// That leaves elements >= pivot in front of the split point and as many
+// elements < pivot behind it; phase 2 swaps those pairwise, in pieces of
+// PARALLEL_GRAIN swaps. Workers claim chunks and pieces from the counters
+// and report each one done; the owner (the worker whose task this is) moves
+// on once all of them are.
+struct PartitionJob {
+    int low = 0;
+    int high = 0;
+    int pivot = 0;
+    int chunks = 0;
+    std::vector<int> lessCounts;
+    std::atomic<int> nextChunk{0};
+    std::atomic<int> doneChunks{0};
+
+    // Misplaced runs on each side of the split as (begin, length), and the
+    // number of swaps before each run.
+    std::vector<int> runBegin[2];
+    std::vector<int> runLength[2];
+    std::vector<int> runOffset[2];
+    int swaps = 0;
+    int pieces = 0;
+    std::atomic<bool> swapsReady{false};
+    std::atomic<int> nextPiece{0};
+    std::atomic<int> donePieces{0};
+
+    // Workers inside help_partition; the job lives on the owner's stack.
+    std::atomic<int> helpers{0};
+    std::atomic<bool> cancelled{false};
+};
+
+struct ParallelSort {
+    int* arr = nullptr;
+    std::vector<StealingDeque> deques;
+    // Tasks pushed and not finished yet; the sort is done when it drops to 0.
+    std::atomic<int> pending{0};
+    // Partitions that idle workers can help with.
+    SDL_SpinLock jobLock = 0;
+    std::vector<PartitionJob*> jobs;
+};
+
+struct ParallelWorker {
+    ParallelSort* sort;
+    int worker;
+};
+
+inline void push_task(StealingDeque& deque, const SortTask& task) {
+    SDL_AtomicLock(&deque.lock);
+    deque.tasks.push_back(task);
+    SDL_AtomicUnlock(&deque.lock);
+}
+
+// Owner side: newest task first.
+inline bool pop_task(StealingDeque& deque, SortTask& task) {
+    SDL_AtomicLock(&deque.lock);
+    bool found = !deque.tasks.empty();
+    if (found) {
+        task = deque.tasks.back();
+        deque.tasks.pop_back();
+    }
+    SDL_AtomicUnlock(&deque.lock);
+    return found;
+}
+
+// Thief side: oldest task first.
+inline bool steal_task(StealingDeque& deque, SortTask& task) {
+    SDL_AtomicLock(&deque.lock);
+    bool found = !deque.tasks.empty();
+    if (found) {
+        task = deque.tasks.front();
+        deque.tasks.pop_front();
+    }
+    SDL_AtomicUnlock(&deque.lock);
+    return found;
+}
+
+// Partitions arr[begin .. end - 1] around pivot, which need not be in it,
+// and returns how many elements are smaller.
+inline int partition_chunk(int arr[], int begin, int end, int pivot) {
+    int i = begin;
+    int j = end - 1;
+    while (true) {
+        while (i <= j && arr[i] < pivot) {
+            i++;
+        }
+        while (i <= j && !(arr[j] < pivot)) {
+            j--;
+        }
+        if (i >= j) {
+            return i - begin;
+        }
+        swap_elements(arr, i, j);
+        i++;
+        j--;
+    }
+}
+
+// Swaps number first .. first + count - 1 of the misplaced pairs.
+inline void swap_piece(int arr[], const PartitionJob& job, int first, int count) {
+    int run[2];
+    int at[2];
+    for (int side = 0; side < 2; side++) {
+        const std::vector<int>& offsets = job.runOffset[side];
+        run[side] = static_cast<int>(std::upper_bound(offsets.begin(), offsets.end(), first) - offsets.begin()) - 1;
+        at[side] = first - offsets[run[side]];
+    }
+    for (int i = 0; i < count; i++) {
+        for (int side = 0; side < 2; side++) {
+            if (at[side] == job.runLength[side][run[side]]) {
+                run[side]++;
+                at[side] = 0;
+            }
+        }
+        swap_elements(arr, job.runBegin[0][run[0]] + at[0], job.runBegin[1][run[1]] + at[1]);
+        at[0]++;
+        at[1]++;
+    }
+}
+
+// Does whatever work of the job is left to claim. A cancel is recorded in
+// the job instead of leaving the claimed item unreported.
+inline void help_partition(int arr[], PartitionJob& job) {
+    int chunkSize = PARALLEL_GRAIN;
+    for (int chunk = job.nextChunk.fetch_add(1); chunk < job.chunks; chunk = job.nextChunk.fetch_add(1)) {
+        int begin = job.low + chunk * chunkSize;
+        int end = std::min(begin + chunkSize, job.high);
+        try {
+            job.lessCounts[chunk] = partition_chunk(arr, begin, end, job.pivot);
+        } catch (const SortCancelled&) {
+            job.cancelled = true;
+        }
+        job.doneChunks.fetch_add(1, std::memory_order_release);
+    }
+
+    if (!job.swapsReady.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (int piece = job.nextPiece.fetch_add(1); piece < job.pieces; piece = job.nextPiece.fetch_add(1)) {
+        int first = piece * PARALLEL_GRAIN;
+        try {
+            swap_piece(arr, job, first, std::min(PARALLEL_GRAIN, job.swaps - first));
+        } catch (const SortCancelled&) {
+            job.cancelled = true;
+        }
+        job.donePieces.fetch_add(1, std::memory_order_release);
+    }
+}
+
+// Idle worker side: helps with the first job that still has work to claim.
+inline bool help_any_partition(ParallelSort& sort) {
+    PartitionJob* job = nullptr;
+    SDL_AtomicLock(&sort.jobLock);
+    for (PartitionJob* candidate : sort.jobs) {
+        bool chunksLeft = candidate->nextChunk.load(std::memory_order_relaxed) < candidate->chunks;
+        bool piecesLeft = candidate->swapsReady.load(std::memory_order_acquire) && candidate->nextPiece.load(std::memory_order_relaxed) < candidate->pieces;
+        if (chunksLeft || piecesLeft) {
+            job = candidate;
+            job->helpers.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&sort.jobLock);
+
+    if (job == nullptr) {
+        return false;
+    }
+    help_partition(sort.arr, *job);
+    job->helpers.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+inline void wait_for_count(const std::atomic<int>& count, int target) {
+    while (count.load(std::memory_order_acquire) < target) {
+        SDL_Delay(0);
+    }
+}
+
+// Owner side. Same contract as lomuto_partition: the pivot is at arr[high]
+// and its final index is returned.
+inline int parallel_partition(ParallelSort& sort, int low, int high) {
+    int* arr = sort.arr;
+    PartitionJob job;
+    job.low = low;
+    job.high = high;
+    job.pivot = arr[high];
+    job.chunks = (high - low + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+    job.lessCounts.assign(job.chunks, 0);
+
+    SDL_AtomicLock(&sort.jobLock);
+    sort.jobs.push_back(&job);
+    SDL_AtomicUnlock(&sort.jobLock);
+
+    help_partition(arr, job);
+    wait_for_count(job.doneChunks, job.chunks);
+
+    // The split point, and the runs on the wrong side of it: the >= parts of
+    // chunks in front of it and the < parts of chunks behind it.
+    int split = low;
+    for (int count : job.lessCounts) {
+        split += count;
+    }
+    int total[2] = {0, 0};
+    for (int chunk = 0; chunk < job.chunks; chunk++) {
+        int begin = low + chunk * PARALLEL_GRAIN;
+        int middle = begin + job.lessCounts[chunk];
+        int end = std::min(begin + PARALLEL_GRAIN, high);
+        int runBegin[2] = {middle, std::max(begin, split)};
+        int runEnd[2] = {std::min(end, split), middle};
+        for (int side = 0; side < 2; side++) {
+            if (runBegin[side] < runEnd[side]) {
+                job.runBegin[side].push_back(runBegin[side]);
+                job.runLength[side].push_back(runEnd[side] - runBegin[side]);
+                job.runOffset[side].push_back(total[side]);
+                total[side] += runEnd[side] - runBegin[side];
+            }
+        }
+    }
+    job.swaps = total[0];
+    job.pieces = (job.swaps + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+    if (!job.cancelled) {
+        job.swapsReady.store(true, std::memory_order_release);
+        help_partition(arr, job);
+        wait_for_count(job.donePieces, job.pieces);
+    }
+
+    SDL_AtomicLock(&sort.jobLock);
+    sort.jobs.erase(std::find(sort.jobs.begin(), sort.jobs.end(), &job));
+    SDL_AtomicUnlock(&sort.jobLock);
+    wait_for_count(job.helpers, 0);
+
+    if (job.cancelled) {
+        throw SortCancelled();
+    }
+    swap_elements(arr, split, high);
+    return split;
+}
+
+inline void run_task(ParallelSort& sort, int worker, SortTask task) {
+    int* arr = sort.arr;
+    while (task.high - task.low + 1 > PARALLEL_GRAIN) {
+        if (task.depthLimit == 0) {
+            heap_sort_range(arr, task.low, task.high);
+            return;
+        }
+        task.depthLimit--;
+
+        swap_elements(arr, choose_pivot(arr, task.low, task.high), task.high);
+        bool shared = task.high - task.low + 1 > PARALLEL_PARTITION_THRESHOLD;
+        int pi = shared ? parallel_partition(sort, task.low, task.high) : lomuto_partition(arr, task.low, task.high);
+        SortTask left = { task.low, pi - 1, task.depthLimit };
+        SortTask right = { pi + 1, task.high, task.depthLimit };
+
+        bool leftLarger = pi - task.low > task.high - pi;
+        sort.pending.fetch_add(1, std::memory_order_relaxed);
+        push_task(sort.deques[worker], leftLarger ? left : right);
+        task = leftLarger ? right : left;
+    }
+    introsort_loop(arr, task.low, task.high, task.depthLimit);
+}
+
+inline int parallel_sort_worker(void* data) {
+    ParallelWorker& self = *static_cast<ParallelWorker*>(data);
+    ParallelSort& sort = *self.sort;
+    int workers = static_cast<int>(sort.deques.size());
+    int idle = 0;
+
+    while (sort.pending.load(std::memory_order_acquire) > 0) {
+        SortTask task;
+        bool found = pop_task(sort.deques[self.worker], task);
+        for (int i = 1; !found && i < workers; i++) {
+            found = steal_task(sort.deques[(self.worker + i) % workers], task);
+        }
+
+        if (found) {
+            // After a cancel the remaining tasks are drained the same way,
+            // each stopping at its next batch of writes.
+            try {
+                run_task(sort, self.worker, task);
+            } catch (const SortCancelled&) {
+            }
+            sort.pending.fetch_sub(1, std::memory_order_release);
+            idle = 0;
+        } else if (help_any_partition(sort)) {
+            idle = 0;
+        } else {
+            SDL_Delay(idle++ < PARALLEL_IDLE_SPINS ? 0 : 1);
+        }
+    }
+
+    flush_placed_count();
+    return 0;
+}
+
+inline void parallel_quicksort(int arr[], int size) {
+    int threads = sortThreads > 0 ? sortThreads : SDL_GetCPUCount();
+    if (threads <= 1 || size <= PARALLEL_GRAIN) {
+        introsort(arr, size);
+        return;
+    }
+
+    ParallelSort sort;
+    sort.arr = arr;
+    sort.deques = std::vector<StealingDeque>(threads);
+    sort.pending = 1;
+    push_task(sort.deques[0], SortTask{ 0, size - 1, depth_limit(size) });
+
+    // The calling thread is worker 0. If a thread cannot be started, the
+    // others simply take over its share.
+    std::vector<ParallelWorker> workers(threads);
+    std::vector<SDL_Thread*> helpers;
+    for (int i = 0; i < threads; i++) {
+        workers[i] = { &sort, i };
+        if (i > 0) {
+            SDL_Thread* thread = SDL_CreateThread(parallel_sort_worker, "sort", &workers[i]);
+            if (thread != nullptr) {
+                helpers.push_back(thread);
+            }
+        }
+    }
+
+    parallel_sort_worker(&workers[0]);
+    for (SDL_Thread* thread : helpers) {
+        SDL_WaitThread(thread, nullptr);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <ostream>
+
+// What a partitioning sort did at each recursion level: how many ranges it
+// split there, how many elements they held and where those went (below the
+// pivot, equal to it or between two pivots, above it). The sort thread
+// records a level per partition; the render loop and the run record read the
+// counters while or after it runs, so they are relaxed atomics.
+
+constexpr int PARTITION_LEVELS = 64;
+
+struct PartitionLevel {
+    std::atomic<long long> partitions{0};
+    std::atomic<long long> elements{0};
+    std::atomic<long long> less{0};
+    std::atomic<long long> between{0};
+    std::atomic<long long> greater{0};
+};
+
+inline PartitionLevel partitionLevels[PARTITION_LEVELS];
+
+// Levels recorded so far, and the level of the latest partition.
+inline std::atomic<int> partitionDepth(0);
+inline std::atomic<int> partitionLevel(-1);
+
+inline void partition_stats_reset() {
+    for (PartitionLevel& level : partitionLevels) {
+        level.partitions.store(0, std::memory_order_relaxed);
+        level.elements.store(0, std::memory_order_relaxed);
+        level.less.store(0, std::memory_order_relaxed);
+        level.between.store(0, std::memory_order_relaxed);
+        level.greater.store(0, std::memory_order_relaxed);
+    }
+    partitionDepth.store(0, std::memory_order_relaxed);
+    partitionLevel.store(-1, std::memory_order_relaxed);
+}
+
+// Levels past the last slot are folded into it. elements also counts pivots
+// that are in none of the three parts.
+inline void record_partition(int level, int elements, int less, int between, int greater) {
+    if (level >= PARTITION_LEVELS) {
+        level = PARTITION_LEVELS - 1;
+    }
+    PartitionLevel& stats = partitionLevels[level];
+    stats.partitions.fetch_add(1, std::memory_order_relaxed);
+    stats.elements.fetch_add(elements, std::memory_order_relaxed);
+    stats.less.fetch_add(less, std::memory_order_relaxed);
+    stats.between.fetch_add(between, std::memory_order_relaxed);
+    stats.greater.fetch_add(greater, std::memory_order_relaxed);
+
+    if (level >= partitionDepth.load(std::memory_order_relaxed)) {
+        partitionDepth.store(level + 1, std::memory_order_relaxed);
+    }
+    partitionLevel.store(level, std::memory_order_relaxed);
+}
+
+inline int partition_stats_depth() {
+    return partitionDepth.load(std::memory_order_relaxed);
+}
+
+// One JSON object per level, for the headless run record.
+inline void print_partition_levels_json(std::ostream& out) {
+    out << "[";
+    for (int i = 0; i < partition_stats_depth(); i++) {
+        const PartitionLevel& level = partitionLevels[i];
+        out << (i > 0 ? "," : "")
+            << "{\"level\":" << i
+            << ",\"partitions\":" << level.partitions.load(std::memory_order_relaxed)
+            << ",\"elements\":" << level.elements.load(std::memory_order_relaxed)
+            << ",\"less\":" << level.less.load(std::memory_order_relaxed)
+            << ",\"between\":" << level.between.load(std::memory_order_relaxed)
+            << ",\"greater\":" << level.greater.load(std::memory_order_relaxed)
+            << "}";
+    }
+    out << "]";
+}
+
+inline void print_partition_levels(std::ostream& out) {
+    out << "level partitions elements less between greater" << std::endl;
+    for (int i = 0; i < partition_stats_depth(); i++) {
+        const PartitionLevel& level = partitionLevels[i];
+        out << i
+            << " " << level.partitions.load(std::memory_order_relaxed)
+            << " " << level.elements.load(std::memory_order_relaxed)
+            << " " << level.less.load(std::memory_order_relaxed)
+            << " " << level.between.load(std::memory_order_relaxed)
+            << " " << level.greater.load(std::memory_order_relaxed) << std::endl;
+    }
+}
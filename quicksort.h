@@ -0,0 +1,407 @@
+#pragma once
+
+#include "array_access.h"
+#include "partition_stats.h"
+
+inline int lomuto_partition(int arr[], int low, int high) {
+    int pivot = arr[high];  
+    int i = (low - 1);  
+
+    for (int j = low; j <= high - 1; j++) {
+        if (arr[j] < pivot) {
+            i++;  
+            swap_elements(arr, i, j);
+        }
+    }
+    swap_elements(arr, i + 1, high);
+    return (i + 1);
+}
+
+inline void quick_sort(int arr[], int low, int high) {
+    if (low < high) {
+        int pi = lomuto_partition(arr, low, high);
+        quick_sort(arr, low, pi - 1);
+        quick_sort(arr, pi + 1, high);
+    }
+}
+
+// Introsort: quick_sort with the pivot taken as the median of three (or, on
+// large ranges, of three medians of three), ranges of up to
+// INTROSORT_CUTOFF elements finished by insertion sort, recursion only into
+// the smaller side and heapsort once a range has been split more than
+// 2 log2(n) times. Sorted, reversed and organ-pipe inputs stay O(n log n)
+// and the stack stays O(log n) deep.
+
+constexpr int INTROSORT_CUTOFF = 16;
+constexpr int NINTHER_THRESHOLD = 128;
+
+inline int median_of_three(const int arr[], int a, int b, int c) {
+    if (arr[a] < arr[b]) {
+        return arr[b] < arr[c] ? b : (arr[a] < arr[c] ? c : a);
+    }
+    return arr[a] < arr[c] ? a : (arr[b] < arr[c] ? c : b);
+}
+
+inline int choose_pivot(const int arr[], int low, int high) {
+    int mid = low + (high - low) / 2;
+    if (high - low + 1 < NINTHER_THRESHOLD) {
+        return median_of_three(arr, low, mid, high);
+    }
+    int step = (high - low) / 8;
+    return median_of_three(arr,
+                           median_of_three(arr, low, low + step, low + 2 * step),
+                           median_of_three(arr, mid - step, mid, mid + step),
+                           median_of_three(arr, high - 2 * step, high - step, high));
+}
+
+inline void insertion_sort_range(int arr[], int low, int high) {
+    for (int i = low + 1; i <= high; ++i) {
+        int key = arr[i];
+        int j = i - 1;
+
+        while (j >= low && arr[j] > key) {
+            set_element(arr, j + 1, arr[j]);
+            --j;
+        }
+
+        set_element(arr, j + 1, key);
+    }
+}
+
+// Max-heap over arr[low .. low + size - 1]; node i has children 2i+1, 2i+2.
+inline void sift_down(int arr[], int low, int node, int size) {
+    while (true) {
+        int largest = node;
+        int left = 2 * node + 1;
+        int right = left + 1;
+        if (left < size && arr[low + left] > arr[low + largest]) {
+            largest = left;
+        }
+        if (right < size && arr[low + right] > arr[low + largest]) {
+            largest = right;
+        }
+        if (largest == node) {
+            return;
+        }
+        swap_elements(arr, low + node, low + largest);
+        node = largest;
+    }
+}
+
+inline void heap_sort_range(int arr[], int low, int high) {
+    int size = high - low + 1;
+    for (int node = size / 2 - 1; node >= 0; --node) {
+        sift_down(arr, low, node, size);
+    }
+    for (int end = size - 1; end > 0; --end) {
+        swap_elements(arr, low, low + end);
+        sift_down(arr, low, 0, end);
+    }
+}
+
+inline int depth_limit(int size) {
+    int depth = 0;
+    while (size > 1) {
+        size >>= 1;
+        depth++;
+    }
+    return 2 * depth;
+}
+
+// Partitions arr[low .. high] around the pivot at arr[high] and returns its
+// final index.
+typedef int (*PartitionFunction)(int arr[], int low, int high);
+
+inline void introsort_loop(int arr[], int low, int high, int depthLimit, PartitionFunction partition = lomuto_partition) {
+    while (high - low + 1 > INTROSORT_CUTOFF) {
+        if (depthLimit == 0) {
+            heap_sort_range(arr, low, high);
+            return;
+        }
+        depthLimit--;
+
+        swap_elements(arr, choose_pivot(arr, low, high), high);
+        int pi = partition(arr, low, high);
+        if (pi - low < high - pi) {
+            introsort_loop(arr, low, pi - 1, depthLimit, partition);
+            low = pi + 1;
+        } else {
+            introsort_loop(arr, pi + 1, high, depthLimit, partition);
+            high = pi - 1;
+        }
+    }
+    insertion_sort_range(arr, low, high);
+}
+
+inline void introsort(int arr[], int size) {
+    introsort_loop(arr, 0, size - 1, depth_limit(size));
+}
+
+// Block partitioning (BlockQuicksort, Edelkamp and Weiss). Lomuto's
+// arr[j] < pivot branch is taken at random on a shuffled input, so about
+// every other comparison is mispredicted. Here the comparisons only decide
+// how far an index is written into an offset buffer: a block of
+// PARTITION_BLOCK elements from the left records which of them belong on the
+// right, a block from the right records the opposite, and then the two lists
+// are swapped pairwise. A block whose list has been used up is done. The
+// last two blocks or less are finished the Lomuto way.
+
+constexpr int PARTITION_BLOCK = 128;
+
+inline int block_partition(int arr[], int low, int high) {
+    int pivot = arr[high];
+    // arr[low .. left - 1] < pivot and arr[right + 1 .. high - 1] >= pivot.
+    int left = low;
+    int right = high - 1;
+
+    int offsetsLeft[PARTITION_BLOCK];
+    int offsetsRight[PARTITION_BLOCK];
+    int startLeft = 0;
+    int countLeft = 0;
+    int startRight = 0;
+    int countRight = 0;
+
+    while (right - left + 1 > 2 * PARTITION_BLOCK) {
+        if (countLeft == 0) {
+            startLeft = 0;
+            for (int j = 0; j < PARTITION_BLOCK; j++) {
+                offsetsLeft[countLeft] = j;
+                countLeft += !(arr[left + j] < pivot);
+            }
+        }
+        if (countRight == 0) {
+            startRight = 0;
+            for (int j = 0; j < PARTITION_BLOCK; j++) {
+                offsetsRight[countRight] = j;
+                countRight += arr[right - j] < pivot;
+            }
+        }
+
+        int count = countLeft < countRight ? countLeft : countRight;
+        for (int j = 0; j < count; j++) {
+            swap_elements(arr, left + offsetsLeft[startLeft + j], right - offsetsRight[startRight + j]);
+        }
+        countLeft -= count;
+        countRight -= count;
+        startLeft += count;
+        startRight += count;
+
+        if (countLeft == 0) {
+            left += PARTITION_BLOCK;
+        }
+        if (countRight == 0) {
+            right -= PARTITION_BLOCK;
+        }
+    }
+
+    // A block that still has entries is only partly swapped; it lies inside
+    // arr[left .. right], so the scan below covers it.
+    int i = left - 1;
+    for (int j = left; j <= right; j++) {
+        if (arr[j] < pivot) {
+            i++;
+            swap_elements(arr, i, j);
+        }
+    }
+    swap_elements(arr, i + 1, high);
+    return i + 1;
+}
+
+// introsort with block_partition in place of lomuto_partition.
+inline void block_quicksort(int arr[], int size) {
+    introsort_loop(arr, 0, size - 1, depth_limit(size), block_partition);
+}
+
+// Dual-pivot quicksort (Yaroslavskiy, as in Java 7's Arrays.sort). Two
+// pivots p <= q split a range into < p, p .. q and > q in one scan, so each
+// element is read by fewer partitioning passes than with one pivot. Cutoff
+// and fallback are introsort's: INTROSORT_CUTOFF elements and below go to
+// insertion sort, and a range split more than 2 log2(n) times is heapsorted.
+// The two smaller parts are recursed into and the largest is looped on. Each
+// partition is recorded in partitionLevels.
+
+// The pivots are the second and fourth of five evenly spaced samples, sorted
+// in place, and end up at arr[low] and arr[high].
+inline void choose_dual_pivots(int arr[], int low, int high) {
+    int size = high - low + 1;
+    int seventh = (size >> 3) + (size >> 6) + 1;
+    int mid = low + size / 2;
+    int samples[5] = { mid - 2 * seventh, mid - seventh, mid, mid + seventh, mid + 2 * seventh };
+
+    for (int i = 1; i < 5; i++) {
+        for (int j = i; j > 0 && arr[samples[j - 1]] > arr[samples[j]]; j--) {
+            swap_elements(arr, samples[j - 1], samples[j]);
+        }
+    }
+    swap_elements(arr, samples[1], low);
+    swap_elements(arr, samples[3], high);
+}
+
+// Partitions arr[low .. high] around p = arr[low] <= q = arr[high]. On return
+// arr[lower] == p, arr[upper] == q, everything before lower is < p,
+// everything after upper is > q and everything between is in p .. q.
+inline void dual_pivot_partition(int arr[], int low, int high, int& lower, int& upper) {
+    if (arr[low] > arr[high]) {
+        swap_elements(arr, low, high);
+    }
+    int p = arr[low];
+    int q = arr[high];
+
+    int less = low + 1;
+    int great = high - 1;
+    for (int k = less; k <= great; k++) {
+        if (arr[k] < p) {
+            swap_elements(arr, k, less);
+            less++;
+        } else if (arr[k] > q) {
+            while (arr[great] > q && k < great) {
+                great--;
+            }
+            swap_elements(arr, k, great);
+            great--;
+            if (arr[k] < p) {
+                swap_elements(arr, k, less);
+                less++;
+            }
+        }
+    }
+
+    lower = less - 1;
+    upper = great + 1;
+    swap_elements(arr, low, lower);
+    swap_elements(arr, high, upper);
+}
+
+inline void dual_pivot_loop(int arr[], int low, int high, int depthLimit, int level) {
+    while (high - low + 1 > INTROSORT_CUTOFF) {
+        if (depthLimit == 0) {
+            heap_sort_range(arr, low, high);
+            return;
+        }
+        depthLimit--;
+
+        choose_dual_pivots(arr, low, high);
+        int lower;
+        int upper;
+        dual_pivot_partition(arr, low, high, lower, upper);
+        record_partition(level, high - low + 1, lower - low, upper - lower - 1, high - upper);
+        level++;
+
+        // With equal pivots the middle part holds only copies of them.
+        int parts[3][2] = { { low, lower - 1 }, { lower + 1, upper - 1 }, { upper + 1, high } };
+        if (arr[lower] == arr[upper]) {
+            parts[1][1] = lower;
+        }
+
+        int largest = 0;
+        for (int i = 1; i < 3; i++) {
+            if (parts[i][1] - parts[i][0] > parts[largest][1] - parts[largest][0]) {
+                largest = i;
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            if (i != largest) {
+                dual_pivot_loop(arr, parts[i][0], parts[i][1], depthLimit, level);
+            }
+        }
+        low = parts[largest][0];
+        high = parts[largest][1];
+    }
+    insertion_sort_range(arr, low, high);
+}
+
+inline void dual_pivot_quicksort(int arr[], int size) {
+    partition_stats_reset();
+    dual_pivot_loop(arr, 0, size - 1, depth_limit(size), 0);
+}
+
+// Three-way quicksort (Bentley and McIlroy, "Engineering a Sort Function").
+// Lomuto's partition sends keys equal to the pivot to one side, so a range
+// of equal keys is split one element at a time and runs of duplicates make
+// quick_sort quadratic. Here a single scan also gathers the keys equal to the
+// pivot at both ends and swaps them into the middle afterwards. That block
+// is final, so each distinct key is partitioned only once. The cost over a
+// two-way scan is an equality test on every element the scan passes, which
+// makes it a little slower than introsort on keys that are all distinct.
+// Pivot choice, cutoff and fallback are introsort's, and each partition is
+// recorded in partitionLevels (between: keys equal to the pivot).
+
+inline void swap_ranges(int arr[], int a, int b, int count) {
+    for (int i = 0; i < count; i++) {
+        swap_elements(arr, a + i, b + i);
+    }
+}
+
+// Partitions arr[low .. high] around the pivot at arr[low]. On return
+// arr[lower .. upper] equal the pivot, everything before lower is smaller
+// and everything after upper is larger.
+inline void three_way_partition(int arr[], int low, int high, int& lower, int& upper) {
+    int pivot = arr[low];
+    // arr[low .. a - 1] == pivot, arr[a .. b - 1] < pivot,
+    // arr[c + 1 .. d] > pivot, arr[d + 1 .. high] == pivot.
+    int a = low + 1;
+    int b = low + 1;
+    int c = high;
+    int d = high;
+    while (true) {
+        while (b <= c && arr[b] <= pivot) {
+            if (arr[b] == pivot) {
+                swap_elements(arr, a, b);
+                a++;
+            }
+            b++;
+        }
+        while (c >= b && arr[c] >= pivot) {
+            if (arr[c] == pivot) {
+                swap_elements(arr, c, d);
+                d--;
+            }
+            c--;
+        }
+        if (b > c) {
+            break;
+        }
+        swap_elements(arr, b, c);
+        b++;
+        c--;
+    }
+
+    int left = a - low < b - a ? a - low : b - a;
+    swap_ranges(arr, low, b - left, left);
+    int right = d - c < high - d ? d - c : high - d;
+    swap_ranges(arr, b, high - right + 1, right);
+
+    lower = low + (b - a);
+    upper = high - (d - c);
+}
+
+inline void three_way_loop(int arr[], int low, int high, int depthLimit, int level) {
+    while (high - low + 1 > INTROSORT_CUTOFF) {
+        if (depthLimit == 0) {
+            heap_sort_range(arr, low, high);
+            return;
+        }
+        depthLimit--;
+
+        swap_elements(arr, choose_pivot(arr, low, high), low);
+        int lower;
+        int upper;
+        three_way_partition(arr, low, high, lower, upper);
+        record_partition(level, high - low + 1, lower - low, upper - lower + 1, high - upper);
+        level++;
+
+        if (lower - low < high - upper) {
+            three_way_loop(arr, low, lower - 1, depthLimit, level);
+            low = upper + 1;
+        } else {
+            three_way_loop(arr, upper + 1, high, depthLimit, level);
+            high = lower - 1;
+        }
+    }
+    insertion_sort_range(arr, low, high);
+}
+
+inline void three_way_quicksort(int arr[], int size) {
+    partition_stats_reset();
+    three_way_loop(arr, 0, size - 1, depth_limit(size), 0);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "array_access.h"
+#include <algorithm>
+#include <vector>
+
+inline void counting_sort_digit(int arr[], int n, int exp) {
+    std::vector<int> output(n);
+    std::vector<int> count(10, 0);
+
+    for (int i = 0; i < n; ++i)
+        ++count[(arr[i] / exp) % 10];
+
+    for (int i = 1; i < 10; ++i)
+        count[i] += count[i - 1];
+
+    for (int i = 0; i < n; i++)
+        output[i] = arr[i];
+
+    for (int i = n - 1; i >= 0; --i) {
+        set_element(arr, count[(output[i] / exp) % 10] - 1, output[i]);
+        --count[(output[i] / exp) % 10];
+    }
+}
+
+inline void radix_sort(int arr[], int n) {
+    int max_element = *std::max_element(arr, arr + n);
+
+    for (int exp = 1; max_element / exp > 0; exp *= 10)
+        counting_sort_digit(arr, n, exp);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "partition_stats.h"
+#include <chrono>
+#include <iostream>
+
+// Headless runs skip the window entirely, sort on the main thread and print
+// one JSON line describing the run, so they can be scripted and compared.
+// Sorts that record partition stats add them per level.
+
+inline bool headlessRun = false;
+inline std::chrono::nanoseconds sortElapsed(0);
+
+inline void print_run_record(const char* algorithm, int width, int height, bool sorted) {
+    std::cout << "{\"algorithm\":\"" << algorithm << "\""
+              << ",\"width\":" << width
+              << ",\"height\":" << height
+              << ",\"elements\":" << static_cast<long long>(width) * height
+              << ",\"ns\":" << sortElapsed.count()
+              << ",\"ms\":" << std::chrono::duration<double, std::milli>(sortElapsed).count()
+              << ",\"sorted\":" << (sorted ? "true" : "false");
+    if (partition_stats_depth() > 0) {
+        std::cout << ",\"partition_levels\":";
+        print_partition_levels_json(std::cout);
+    }
+    std::cout << "}" << std::endl;
+}
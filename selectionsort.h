@@ -0,0 +1,15 @@
+#pragma once
+
+#include "array_access.h"
+
+inline void selection_sort(int arr[], int size) {
+    for (int i = 0; i < size - 1; ++i) {
+        int min_idx = i;
+        for (int j = i + 1; j < size; ++j) {
+            if (arr[j] < arr[min_idx]) {
+                min_idx = j;
+            }
+        }
+        swap_elements(arr, i, min_idx);
+    }
+}
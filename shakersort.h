@@ -0,0 +1,35 @@
+#pragma once
+
+#include "array_access.h"
+
+inline void shaker_sort(int arr[], int pixels) {
+    bool swapped = true;
+    int start = 0;
+    int end = pixels - 1;
+
+    while (swapped) {
+        swapped = false;
+
+        for (int i = start; i < end; ++i) {
+            if (arr[i] > arr[i + 1]) {
+                swap_elements(arr, i, i + 1);
+                swapped = true;
+            }
+        }
+
+        if (!swapped)
+            break;
+
+        swapped = false;
+        --end;
+
+        for (int i = end - 1; i >= start; --i) {
+            if (arr[i] > arr[i + 1]) {
+                swap_elements(arr, i, i + 1);
+                swapped = true;
+            }
+        }
+
+        ++start;
+    }
+}
@@ -0,0 +1,275 @@
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "compositor.h"
+#include "frame_export.h"
+#include "frame_pacer.h"
+#include "compose_thread.h"
+#include "options.h"
+#include "run_record.h"
+#include "sort_registry.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <atomic>
+
+#undef main
+
+constexpr float UPDATE_FREQUENCY = 1;
+constexpr float TARGET_FRAME_TIME = 1000.0f / 30.0f;
+
+const int WINDOW_WIDTH = 1000;
+const int WINDOW_HEIGHT = 600;
+
+std::atomic<bool> sortingFinished(false);
+
+struct SortArgs {
+    const SortAlgorithm* algorithm;
+    int* arr;
+    int size;
+};
+
+int sort(void* args) {
+    auto timer_start = std::chrono::high_resolution_clock::now();
+
+    SortArgs* sortArgs = static_cast<SortArgs*>(args);
+    // Parallel kernels catch the cancel on their own threads, so look at the
+    // flag rather than only at what reaches this one.
+    try {
+        sortArgs->algorithm->sort(sortArgs->arr, sortArgs->size);
+    } catch (const SortCancelled&) {
+    }
+    flush_placed_count();
+    bool cancelled = sortCancelled.load();
+
+    auto timer_end = std::chrono::high_resolution_clock::now();
+    sortElapsed = timer_end - timer_start;
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(timer_end - timer_start);
+    if (cancelled) {
+        std::cout << "Sorting cancelled after: " << duration.count() << "ms" << std::endl << std::endl;
+    } else if (!headlessRun) {
+        std::cout << "Sorting Finished in: " << duration.count() << "ms" << std::endl << std::endl;
+        if (partition_stats_depth() > 0) {
+            std::cout << "Partitions per recursion level:" << std::endl;
+            print_partition_levels(std::cout);
+            std::cout << std::endl;
+        }
+    }
+    sortingFinished = true;
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options = parse_options(argc, argv);
+
+    const SortAlgorithm* algorithm = find_sort_algorithm(options.algorithm);
+    if (algorithm == nullptr) {
+        std::cerr << "Unknown algorithm: " << options.algorithm << std::endl;
+        print_sort_algorithms(std::cerr);
+        return 1;
+    }
+    sortThreads = options.sortThreads;
+
+    // Write events and frame export both expect a single writing thread.
+    if (algorithm->parallel && (options.writeEvents || !options.exportPath.empty())) {
+        std::cerr << algorithm->name << " writes from several threads and ignores --events and --export" << std::endl;
+        options.writeEvents = false;
+        options.exportPath.clear();
+    }
+
+    SDL_Surface* surface = SDL_LoadBMP("image.bmp");
+    if (surface == nullptr) {
+        std::cerr << "Failed to load image! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    const int WIDTH = surface->w;
+    const int HEIGHT = surface->h;
+
+    const int pixels = WIDTH * HEIGHT;
+
+    std::vector<int> arr(pixels);
+    for (int i = 0; i < pixels; i++){
+        arr[i] = i;
+    }
+
+    unsigned seed = options.seed != 0 ? options.seed : std::chrono::system_clock::now().time_since_epoch().count();
+    std::shuffle(arr.begin(), arr.end(), std::default_random_engine(seed));
+    array_tracking_init(arr.data(), pixels);
+
+    if (options.headless) {
+        SDL_FreeSurface(surface);
+        headlessRun = true;
+
+        SortArgs args = { algorithm, arr.data(), pixels };
+        sort(&args);
+
+        print_run_record(algorithm->name, WIDTH, HEIGHT, placed_count() == pixels);
+        return 0;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    SDL_Window* window = SDL_CreateWindow("Image Rendering", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
+    if (window == nullptr) {
+        std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    if (renderer == nullptr) {
+        std::cerr << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    SDL_RenderSetLogicalSize(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    Compositor compositor;
+    compositor.mapping = options.mapping;
+    bool composited = compositor_init(compositor, renderer, surface, WINDOW_WIDTH, WINDOW_HEIGHT, options.renderCopy);
+    SDL_FreeSurface(surface);
+    if (!composited) {
+        std::cerr << "Failed to create streaming texture! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    if (compositor.mapping != options.mapping) {
+        std::cerr << "The image is too large for the " << mapping_name(options.mapping) << " mapping, using " << mapping_name(compositor.mapping) << std::endl;
+    }
+    if (!compositor_start_workers(compositor, options.composeThreads)) {
+        std::cerr << "Compose workers could not be started, compositing on one thread. SDL_Error: " << SDL_GetError() << std::endl;
+    }
+    compositor.budgetMs = options.frameBudget >= 0 ? options.frameBudget : TARGET_FRAME_TIME / 2;
+    compositor.scramble = options.scramble;
+
+    FrameExporter exporter;
+    bool exporting = !options.exportPath.empty();
+    if (exporting && !exporter_start(exporter, options.exportPath, WINDOW_WIDTH, WINDOW_HEIGHT, options.exportEvery)) {
+        std::cerr << "Frame export could not be started: " << options.exportPath << std::endl;
+        return 1;
+    }
+
+    SDL_RenderClear(renderer);
+
+    SDL_Event event;
+    bool running = true;
+
+    WriteRing ring;
+    if (options.writeEvents) {
+        write_ring_init(ring, WRITE_RING_CAPACITY);
+        writeRing = &ring;
+    }
+
+    std::cout << "Press 'Enter' while in the render window to Start:" << std::endl;
+    bool key_pressed = false;
+    while (!key_pressed) {
+        while (SDL_WaitEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                key_pressed = true;
+                break;
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_RETURN) {
+                key_pressed = true;
+                break;
+            }
+        }
+    }
+    std::cout << "Sorting with " << algorithm->name << "..." << std::endl;
+
+    FramePacer pacer;
+    FrameHandoff handoff;
+    if (!pacer_start(pacer, TARGET_FRAME_TIME) || !handoff_init(handoff, WINDOW_WIDTH * WINDOW_HEIGHT)) {
+        std::cerr << "Frame scheduling could not be started! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    ComposeLoop loop = { &compositor, arr.data(), pixels, &sortingFinished, UPDATE_FREQUENCY, &pacer, &handoff, exporting ? &exporter : nullptr };
+    ViewControl viewControl;
+    view_control_init(viewControl, WIDTH, HEIGHT, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    SortArgs args = { algorithm, arr.data(), pixels };
+    SDL_Thread* sortThread = SDL_CreateThread(sort, "sort", &args);
+    if (sortThread == nullptr) {
+        std::cerr << "Sort thread could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    SDL_Thread* composeThread = SDL_CreateThread(compose_loop, "compositor", &loop);
+    if (composeThread == nullptr) {
+        std::cerr << "Compositor thread could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    while (running && SDL_WaitEvent(&event) != 0) {
+        if (event.type == SDL_QUIT) {
+            sortCancelled = true;
+            running = false;
+            break;
+        }
+
+        if (view_handle_event(viewControl, event)) {
+            compose_loop_request_view(loop, viewControl.view);
+        }
+
+        if (handoff_ready_event(handoff, event)) {
+            const Uint32* frame = handoff_take(handoff);
+            if (frame != nullptr) {
+                present_pixels(compositor, frame, handoff_view(handoff));
+                show_progress(window, compositor, placed_count(), pixels);
+            }
+            if (loop.finished) {
+                running = false;
+                break;
+            }
+        }
+    }
+    compose_loop_stop(loop, composeThread);
+    compositor_set_view(compositor, viewControl.view);
+    compose_frame(compositor, arr.data());
+    present_frame(compositor);
+    show_progress(window, compositor, placed_count(), pixels);
+
+    if (exporting) {
+        compose_export_frame(compositor, arr.data(), exporter);
+        exporter_finish(exporter);
+        std::cout << "Frames exported to " << options.exportPath << ": " << exporter.framesWritten << std::endl;
+    }
+
+    if (writeRing != nullptr) {
+        std::cout << "Write events that fell back to tile rescans: " << ring.dropped << std::endl;
+    }
+    print_pacer_stats(pacer);
+    std::cout << "Frames presented: " << handoff.presented << "/" << handoff.published << " composited" << std::endl;
+    if (compositor.budgetMs > 0) {
+        std::cout << "Frames left coarse by the compose budget: " << compositor.degradedFrames << "/" << compositor.composedFrames << std::endl;
+    }
+
+    std::cout << "Press 'Enter' while in the render window to Exit:";
+    key_pressed = false;
+    while (!key_pressed) {
+        while (SDL_WaitEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                key_pressed = true;
+                break;
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_RETURN) {
+                key_pressed = true;
+                break;
+            }
+        }
+    }
+
+    // If the window was closed early the sort was cancelled and stops at its
+    // next batch of writes; it still writes to arr until then.
+    SDL_WaitThread(sortThread, nullptr);
+
+    compositor_destroy(compositor);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    return 0;
+}
+
+//g++ sort.cpp -o sort.exe -Iinc -Llib -lSDL2 -lopengl32
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include "inc/SDL.h"
+#include "array_access.h"
+#include "sort_registry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#undef main
+
+// Times every registered sort (or the ones named with --algorithm) at a list
+// of sizes without opening a window. Each size gets a few untimed warmup
+// runs, then every repetition sorts a fresh shuffle seeded from --seed, the
+// size and the repetition, so the inputs are the same from run to run and
+// differ between repetitions. --input picks an ordered pattern instead of a
+// shuffle, to time the worst cases of simple pivot rules, or shuffled keys
+// with only DUPLICATE_KEYS distinct values. By default every size runs twice:
+// once with writes going through the same tracking as in the driver (placed
+// count, dirty tiles), so the numbers compare with it, and once with plain
+// stores, so the kernels compare on their own cost. --writes tracked|plain
+// runs only one of them.
+// Parallel kernels run once per thread count in --threads and report their
+// scaling efficiency against the first count: (T_first * first) / (T_n * n),
+// from the medians. Where the kernel lets us read the CPU's branch-miss
+// counter (Linux perf events), the median misses per element are reported
+// too; elsewhere the column is -1.
+
+struct BenchOptions {
+    std::vector<std::string> algorithms;
+    std::vector<int> sizes = { 1 << 10, 1 << 14, 1 << 17, 1 << 20 };
+    std::vector<int> threads;
+    int warmups = 2;
+    int repetitions = 10;
+    unsigned seed = 1;
+    std::string input = "random";
+    std::string writes = "both";
+    bool json = false;
+};
+
+struct BenchStats {
+    double min = 0;
+    double median = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double mean = 0;
+    double stddev = 0;
+    double branchMisses = -1;
+};
+
+// Counts mispredicted branches in user space. open_branch_counter leaves fd
+// at -1 when there is no counter to read.
+struct BranchCounter {
+    int fd = -1;
+};
+
+void open_branch_counter(BranchCounter& counter) {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Count the threads a parallel sort starts as well.
+    attr.inherit = 1;
+    counter.fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+void start_branch_counter(BranchCounter& counter) {
+#ifdef __linux__
+    if (counter.fd >= 0) {
+        ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+// Misses since start_branch_counter, or -1 without a counter.
+long long stop_branch_counter(BranchCounter& counter) {
+    long long misses = -1;
+#ifdef __linux__
+    if (counter.fd >= 0) {
+        ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter.fd, &misses, sizeof(misses)) != sizeof(misses)) {
+            misses = -1;
+        }
+    }
+#endif
+    return misses;
+}
+
+std::vector<int> parse_counts(const char* list) {
+    std::vector<int> sizes;
+    for (const char* p = list; *p != '\0';) {
+        char* end = nullptr;
+        long size = std::strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        if (size > 0) {
+            sizes.push_back(static_cast<int>(size));
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return sizes;
+}
+
+BenchOptions parse_bench_options(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--algorithm") == 0 && i + 1 < argc) {
+            options.algorithms.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            options.sizes = parse_counts(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = parse_counts(argv[++i]);
+        } else if (std::strcmp(argv[i], "--warmups") == 0 && i + 1 < argc) {
+            options.warmups = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            options.input = argv[++i];
+        } else if (std::strcmp(argv[i], "--writes") == 0 && i + 1 < argc) {
+            options.writes = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            options.json = std::strcmp(argv[++i], "json") == 0;
+        } else {
+            std::cerr << "Ignoring unknown option: " << argv[i] << std::endl;
+        }
+    }
+    // Powers of two up to the core count, and the core count itself.
+    if (options.threads.empty()) {
+        int cores = SDL_GetCPUCount();
+        for (int threads = 1; threads < cores; threads *= 2) {
+            options.threads.push_back(threads);
+        }
+        options.threads.push_back(cores);
+    }
+    return options;
+}
+
+// Nearest-rank percentile of sorted samples.
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+BenchStats summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+
+    BenchStats stats;
+    stats.min = samples.front();
+    stats.median = samples.size() % 2 == 1 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+    stats.p90 = percentile(samples, 90);
+    stats.p99 = percentile(samples, 99);
+
+    for (double sample : samples) {
+        stats.mean += sample;
+    }
+    stats.mean /= samples.size();
+    for (double sample : samples) {
+        stats.stddev += (sample - stats.mean) * (sample - stats.mean);
+    }
+    stats.stddev = samples.size() > 1 ? std::sqrt(stats.stddev / (samples.size() - 1)) : 0;
+    return stats;
+}
+
+const char* const BENCH_INPUTS[] = { "random", "sorted", "reversed", "organ-pipe", "duplicates" };
+
+// Distinct keys of the duplicates input, as many as an 8-bit color or
+// luminance channel has.
+constexpr int DUPLICATE_KEYS = 256;
+
+bool known_input(const std::string& input) {
+    for (const char* name : BENCH_INPUTS) {
+        if (input == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fills arr[0 .. size - 1] with a permutation of 0 .. size - 1 in the given
+// pattern: shuffled, ascending, descending, or ascending evens followed by
+// descending odds (organ pipe). duplicates is not a permutation: slot i holds
+// i quantized to DUPLICATE_KEYS levels, shuffled.
+void fill_input(std::vector<int>& arr, int size, const std::string& input, std::mt19937& engine) {
+    for (int i = 0; i < size; i++) {
+        if (input == "reversed") {
+            arr[i] = size - 1 - i;
+        } else if (input == "organ-pipe") {
+            arr[i] = i < (size + 1) / 2 ? 2 * i : 2 * (size - 1 - i) + 1;
+        } else if (input == "duplicates") {
+            arr[i] = static_cast<int>(static_cast<long long>(i) * DUPLICATE_KEYS / size);
+        } else {
+            arr[i] = i;
+        }
+    }
+    if (input == "random" || input == "duplicates") {
+        std::shuffle(arr.begin(), arr.begin() + size, engine);
+    }
+}
+
+// Largest size to run algorithm at on the given input, 0 for any.
+int bench_limit(const SortAlgorithm& algorithm, const std::string& input) {
+    int limit = algorithm.benchLimit;
+    if (input != "random" && algorithm.orderedBenchLimit > 0 && (limit == 0 || algorithm.orderedBenchLimit < limit)) {
+        limit = algorithm.orderedBenchLimit;
+    }
+    return limit;
+}
+
+// Sorts one fresh input and returns the time taken in nanoseconds, or a
+// negative time if the result is not sorted. misses gets the branch misses of
+// the sort (-1 without a counter).
+double time_sort(const SortAlgorithm& algorithm, std::vector<int>& arr, const BenchOptions& options, int size, int repetition, BranchCounter& counter, long long& misses) {
+    std::seed_seq sequence = { options.seed, static_cast<unsigned>(size), static_cast<unsigned>(repetition) };
+    std::mt19937 engine(sequence);
+    fill_input(arr, size, options.input, engine);
+    array_tracking_init(arr.data(), size);
+
+    start_branch_counter(counter);
+    auto timer_start = std::chrono::steady_clock::now();
+    algorithm.sort(arr.data(), size);
+    flush_placed_count();
+    auto timer_end = std::chrono::steady_clock::now();
+    misses = stop_branch_counter(counter);
+
+    // A permutation is sorted once every slot holds its own index. The
+    // placed count cannot be used for that, as plain writes do not keep it.
+    bool sorted = options.input == "duplicates" ? std::is_sorted(arr.begin(), arr.begin() + size) : count_placed(arr.data(), 0, size) == size;
+    if (!sorted) {
+        return -1;
+    }
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(timer_end - timer_start).count());
+}
+
+void print_header(const BenchOptions& options) {
+    if (!options.json) {
+        std::cout << "algorithm,input,writes,elements,warmups,repetitions,seed,threads,min_ns,median_ns,p90_ns,p99_ns,mean_ns,stddev_ns,ns_per_element,efficiency,branch_misses_per_element" << std::endl;
+    }
+}
+
+void print_result(const BenchOptions& options, const SortAlgorithm& algorithm, int size, int threads, double efficiency, const BenchStats& stats) {
+    double perElement = stats.median / size;
+    double missesPerElement = stats.branchMisses < 0 ? -1 : stats.branchMisses / size;
+    const char* writes = trackWrites ? "tracked" : "plain";
+    if (options.json) {
+        std::cout << "{\"algorithm\":\"" << algorithm.name << "\""
+                  << ",\"input\":\"" << options.input << "\""
+                  << ",\"writes\":\"" << writes << "\""
+                  << ",\"elements\":" << size
+                  << ",\"warmups\":" << options.warmups
+                  << ",\"repetitions\":" << options.repetitions
+                  << ",\"seed\":" << options.seed
+                  << ",\"threads\":" << threads
+                  << ",\"min_ns\":" << stats.min
+                  << ",\"median_ns\":" << stats.median
+                  << ",\"p90_ns\":" << stats.p90
+                  << ",\"p99_ns\":" << stats.p99
+                  << ",\"mean_ns\":" << stats.mean
+                  << ",\"stddev_ns\":" << stats.stddev
+                  << ",\"ns_per_element\":" << perElement
+                  << ",\"efficiency\":" << efficiency
+                  << ",\"branch_misses_per_element\":" << missesPerElement
+                  << "}" << std::endl;
+        return;
+    }
+    std::cout << algorithm.name << "," << options.input << "," << writes << "," << size << "," << options.warmups << "," << options.repetitions << "," << options.seed << "," << threads << ","
+              << stats.min << "," << stats.median << "," << stats.p90 << "," << stats.p99 << "," << stats.mean << "," << stats.stddev << ","
+              << perElement << "," << efficiency << "," << missesPerElement << std::endl;
+}
+
+// Warmups, then the timed repetitions of one algorithm at one size.
+bool bench_size(const BenchOptions& options, const SortAlgorithm& algorithm, std::vector<int>& arr, int size, BranchCounter& counter, BenchStats& stats) {
+    long long misses = 0;
+    // Warmups use repetition numbers past the timed ones, so they never
+    // sort the same input.
+    for (int warmup = 0; warmup < options.warmups; warmup++) {
+        time_sort(algorithm, arr, options, size, options.repetitions + warmup, counter, misses);
+    }
+
+    std::vector<double> samples;
+    std::vector<double> missSamples;
+    for (int repetition = 0; repetition < options.repetitions; repetition++) {
+        double ns = time_sort(algorithm, arr, options, size, repetition, counter, misses);
+        if (ns < 0) {
+            std::cerr << algorithm.name << " did not sort " << size << " elements!" << std::endl;
+            return false;
+        }
+        samples.push_back(ns);
+        if (misses >= 0) {
+            missSamples.push_back(static_cast<double>(misses));
+        }
+    }
+
+    stats = summarize(samples);
+    if (missSamples.size() == samples.size()) {
+        stats.branchMisses = summarize(missSamples).median;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = parse_bench_options(argc, argv);
+    std::cout.precision(12);
+
+    std::vector<const SortAlgorithm*> algorithms;
+    if (options.algorithms.empty()) {
+        for (const SortAlgorithm& algorithm : SORT_ALGORITHMS) {
+            algorithms.push_back(&algorithm);
+        }
+    }
+    for (const std::string& name : options.algorithms) {
+        const SortAlgorithm* algorithm = find_sort_algorithm(name);
+        if (algorithm == nullptr) {
+            std::cerr << "Unknown algorithm: " << name << std::endl;
+            print_sort_algorithms(std::cerr);
+            return 1;
+        }
+        algorithms.push_back(algorithm);
+    }
+    if (!known_input(options.input)) {
+        std::cerr << "Unknown input: " << options.input << std::endl;
+        return 1;
+    }
+    std::vector<bool> trackings;
+    if (options.writes == "tracked" || options.writes == "both") {
+        trackings.push_back(true);
+    }
+    if (options.writes == "plain" || options.writes == "both") {
+        trackings.push_back(false);
+    }
+    if (trackings.empty()) {
+        std::cerr << "Unknown writes: " << options.writes << " (tracked, plain or both)" << std::endl;
+        return 1;
+    }
+    if (options.sizes.empty()) {
+        std::cerr << "No sizes to run" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> arr(*std::max_element(options.sizes.begin(), options.sizes.end()));
+    BranchCounter counter;
+    open_branch_counter(counter);
+    print_header(options);
+
+    for (const SortAlgorithm* algorithm : algorithms) {
+        for (int size : options.sizes) {
+            int limit = bench_limit(*algorithm, options.input);
+            if (limit > 0 && size > limit) {
+                std::cerr << "Skipping " << algorithm->name << " at " << size << " elements (limit " << limit << " on " << options.input << " input)" << std::endl;
+                continue;
+            }
+
+            std::vector<int> threadCounts = algorithm->parallel ? options.threads : std::vector<int>{ 1 };
+            for (bool tracking : trackings) {
+                trackWrites = tracking;
+                double baseline = 0;
+                int baselineThreads = 0;
+                for (int threads : threadCounts) {
+                    sortThreads = threads;
+                    BenchStats stats;
+                    if (!bench_size(options, *algorithm, arr, size, counter, stats)) {
+                        return 1;
+                    }
+                    if (baselineThreads == 0) {
+                        baseline = stats.median;
+                        baselineThreads = threads;
+                    }
+                    print_result(options, *algorithm, size, threads, baseline * baselineThreads / (stats.median * threads), stats);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+//g++ -O2 sort_bench.cpp -o sort_bench.exe -Iinc -Llib -lSDL2
\ No newline at end of file
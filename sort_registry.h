@@ -0,0 +1,68 @@
+#pragma once
+
+#include "bogosort.h"
+#include "bubblesort.h"
+#include "countingsort.h"
+#include "insertionsort.h"
+#include "mergesort.h"
+#include "parallel_quicksort.h"
+#include "quicksort.h"
+#include "radixsort.h"
+#include "selectionsort.h"
+#include "shakersort.h"
+#include <iostream>
+#include <string>
+
+// Every sort the driver can run. A kernel sorts arr[0 .. size - 1] in place
+// and writes only through set_element/swap_elements, so the harness can
+// follow it; adding one is a header with the kernel plus a line here.
+// benchLimit is the largest size sort_bench runs it at (0: any size), so the
+// quadratic sorts and bogosort do not stall a sweep. orderedBenchLimit is
+// the same for every --input but random, for sorts that only go quadratic
+// on ordered or duplicate keys. parallel kernels write from several threads
+// (see sortThreads in parallel_quicksort.h).
+
+typedef void (*SortKernel)(int arr[], int size);
+
+struct SortAlgorithm {
+    const char* name;
+    SortKernel sort;
+    int benchLimit;
+    int orderedBenchLimit;
+    bool parallel;
+};
+
+inline const SortAlgorithm SORT_ALGORITHMS[] = {
+    { "quicksort", [](int arr[], int size) { quick_sort(arr, 0, size - 1); }, 0, 1 << 14, false },
+    { "introsort", introsort, 0, 0, false },
+    { "blockquicksort", block_quicksort, 0, 0, false },
+    { "dualpivot", dual_pivot_quicksort, 0, 0, false },
+    { "threeway", three_way_quicksort, 0, 0, false },
+    { "parallel-quicksort", parallel_quicksort, 0, 0, true },
+    { "mergesort", [](int arr[], int size) { merge_sort(arr, 0, size - 1); }, 0, 0, false },
+    { "bubblesort", bubble_sort, 1 << 15, 0, false },
+    { "insertionsort", insertion_sort, 1 << 15, 0, false },
+    { "selectionsort", selection_sort, 1 << 15, 0, false },
+    { "countingsort", counting_sort, 0, 0, false },
+    { "shakersort", shaker_sort, 1 << 15, 0, false },
+    { "radixsort", radix_sort, 0, 0, false },
+    { "bogosort", bogo_sort, 8, 0, false },
+};
+
+// Returns nullptr for names that are not registered.
+inline const SortAlgorithm* find_sort_algorithm(const std::string& name) {
+    for (const SortAlgorithm& algorithm : SORT_ALGORITHMS) {
+        if (name == algorithm.name) {
+            return &algorithm;
+        }
+    }
+    return nullptr;
+}
+
+inline void print_sort_algorithms(std::ostream& out) {
+    out << "Available algorithms:";
+    for (const SortAlgorithm& algorithm : SORT_ALGORITHMS) {
+        out << " " << algorithm.name;
+    }
+    out << std::endl;
+}
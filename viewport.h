@@ -0,0 +1,107 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include <algorithm>
+#include <cmath>
+
+// The part of the image shown in the window, in source pixels. The whole
+// image is the widest view; the mouse wheel zooms around the cursor and
+// dragging with the left button pans. The view keeps the image's aspect
+// ratio and never leaves the image.
+
+// Largest zoom, in window pixels per source pixel.
+constexpr float VIEW_MAX_MAGNIFICATION = 16.0f;
+constexpr float VIEW_ZOOM_STEP = 1.25f;
+
+struct Viewport {
+    float x = 0;
+    float y = 0;
+    float width = 0;
+    float height = 0;
+};
+
+struct ViewControl {
+    Viewport view;
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int dstWidth = 0;
+    int dstHeight = 0;
+    bool dragging = false;
+};
+
+inline Viewport full_view(int srcWidth, int srcHeight) {
+    return { 0, 0, static_cast<float>(srcWidth), static_cast<float>(srcHeight) };
+}
+
+// The source column (or row) window column dstX samples. Shared by the
+// compositor's lookup tables and anything that needs them for an older view.
+inline int view_source_column(const Viewport& view, int dstX, int dstWidth, int srcWidth) {
+    float scaleX = static_cast<float>(dstWidth) / view.width;
+    return std::min(static_cast<int>(view.x + dstX / scaleX), srcWidth - 1);
+}
+
+inline int view_source_row(const Viewport& view, int dstY, int dstHeight, int srcHeight) {
+    float scaleY = static_cast<float>(dstHeight) / view.height;
+    return std::min(static_cast<int>(view.y + dstY / scaleY), srcHeight - 1);
+}
+
+inline void view_control_init(ViewControl& control, int srcWidth, int srcHeight, int dstWidth, int dstHeight) {
+    control.srcWidth = srcWidth;
+    control.srcHeight = srcHeight;
+    control.dstWidth = dstWidth;
+    control.dstHeight = dstHeight;
+    control.view = full_view(srcWidth, srcHeight);
+}
+
+inline void clamp_view(ViewControl& control) {
+    Viewport& view = control.view;
+    view.x = std::min(std::max(view.x, 0.0f), control.srcWidth - view.width);
+    view.y = std::min(std::max(view.y, 0.0f), control.srcHeight - view.height);
+}
+
+// Scales the view by factor (below 1 zooms in) keeping the source point
+// under window position (dstX, dstY) where it is.
+inline void zoom_view(ViewControl& control, int dstX, int dstY, float factor) {
+    Viewport& view = control.view;
+    float minWidth = std::min(control.dstWidth / VIEW_MAX_MAGNIFICATION, static_cast<float>(control.srcWidth));
+    float width = std::min(std::max(view.width * factor, minWidth), static_cast<float>(control.srcWidth));
+    float height = width * control.srcHeight / control.srcWidth;
+
+    float u = static_cast<float>(dstX) / control.dstWidth;
+    float v = static_cast<float>(dstY) / control.dstHeight;
+    view.x += (view.width - width) * u;
+    view.y += (view.height - height) * v;
+    view.width = width;
+    view.height = height;
+    if (width == control.srcWidth) {
+        view = full_view(control.srcWidth, control.srcHeight);
+    }
+    clamp_view(control);
+}
+
+inline void pan_view(ViewControl& control, int dx, int dy) {
+    Viewport& view = control.view;
+    view.x -= dx * view.width / control.dstWidth;
+    view.y -= dy * view.height / control.dstHeight;
+    clamp_view(control);
+}
+
+// Applies mouse input to the view; returns true when the view changed.
+inline bool view_handle_event(ViewControl& control, const SDL_Event& event) {
+    if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+        int mouseX = 0;
+        int mouseY = 0;
+        SDL_GetMouseState(&mouseX, &mouseY);
+        zoom_view(control, mouseX, mouseY, std::pow(VIEW_ZOOM_STEP, static_cast<float>(-event.wheel.y)));
+        return true;
+    }
+    if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+        control.dragging = true;
+    } else if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_LEFT) {
+        control.dragging = false;
+    } else if (event.type == SDL_MOUSEMOTION && control.dragging && (event.motion.xrel != 0 || event.motion.yrel != 0)) {
+        pan_view(control, event.motion.xrel, event.motion.yrel);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "inc/SDL.h"
+#include <vector>
+
+// Fork/join pool on SDL threads. pool_run wakes every worker on the same job,
+// runs it on the calling thread as worker 0 as well, and returns once all of
+// them are done, which is the barrier the compositor needs before presenting.
+
+typedef void (*PoolJob)(void* context, int worker);
+
+struct WorkerPool;
+
+struct PoolWorker {
+    WorkerPool* pool;
+    int worker;
+};
+
+struct WorkerPool {
+    std::vector<SDL_Thread*> threads;
+    std::vector<PoolWorker> workers;
+    SDL_mutex* mutex = nullptr;
+    SDL_cond* wake = nullptr;
+    SDL_cond* idle = nullptr;
+    PoolJob job = nullptr;
+    void* context = nullptr;
+    int generation = 0;
+    int running = 0;
+    bool quit = false;
+};
+
+inline int pool_worker(void* data) {
+    PoolWorker* worker = static_cast<PoolWorker*>(data);
+    WorkerPool& pool = *worker->pool;
+    int seen = 0;
+
+    SDL_LockMutex(pool.mutex);
+    while (true) {
+        while (!pool.quit && pool.generation == seen) {
+            SDL_CondWait(pool.wake, pool.mutex);
+        }
+        if (pool.quit) {
+            break;
+        }
+        seen = pool.generation;
+        PoolJob job = pool.job;
+        void* context = pool.context;
+        SDL_UnlockMutex(pool.mutex);
+
+        job(context, worker->worker);
+
+        SDL_LockMutex(pool.mutex);
+        if (--pool.running == 0) {
+            SDL_CondSignal(pool.idle);
+        }
+    }
+    SDL_UnlockMutex(pool.mutex);
+
+    return 0;
+}
+
+// Starts threads extra workers; the caller of pool_run is worker 0, so jobs
+// see worker indices 0..threads.
+inline bool pool_init(WorkerPool& pool, int threads) {
+    pool.mutex = SDL_CreateMutex();
+    pool.wake = SDL_CreateCond();
+    pool.idle = SDL_CreateCond();
+    if (pool.mutex == nullptr || pool.wake == nullptr || pool.idle == nullptr) {
+        return false;
+    }
+
+    pool.workers.resize(threads);
+    for (int i = 0; i < threads; i++) {
+        pool.workers[i] = { &pool, i + 1 };
+        SDL_Thread* thread = SDL_CreateThread(pool_worker, "compose", &pool.workers[i]);
+        if (thread == nullptr) {
+            return false;
+        }
+        pool.threads.push_back(thread);
+    }
+
+    return true;
+}
+
+inline int pool_size(const WorkerPool& pool) {
+    return static_cast<int>(pool.threads.size()) + 1;
+}
+
+inline void pool_run(WorkerPool& pool, PoolJob job, void* context) {
+    SDL_LockMutex(pool.mutex);
+    pool.job = job;
+    pool.context = context;
+    pool.running = static_cast<int>(pool.threads.size());
+    pool.generation++;
+    SDL_CondBroadcast(pool.wake);
+    SDL_UnlockMutex(pool.mutex);
+
+    job(context, 0);
+
+    SDL_LockMutex(pool.mutex);
+    while (pool.running > 0) {
+        SDL_CondWait(pool.idle, pool.mutex);
+    }
+    SDL_UnlockMutex(pool.mutex);
+}
+
+inline void pool_destroy(WorkerPool& pool) {
+    if (pool.mutex != nullptr) {
+        SDL_LockMutex(pool.mutex);
+        pool.quit = true;
+        SDL_CondBroadcast(pool.wake);
+        SDL_UnlockMutex(pool.mutex);
+    }
+
+    for (SDL_Thread* thread : pool.threads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    pool.threads.clear();
+
+    if (pool.idle != nullptr) {
+        SDL_DestroyCond(pool.idle);
+    }
+    if (pool.wake != nullptr) {
+        SDL_DestroyCond(pool.wake);
+    }
+    if (pool.mutex != nullptr) {
+        SDL_DestroyMutex(pool.mutex);
+    }
+    pool.idle = nullptr;
+    pool.wake = nullptr;
+    pool.mutex = nullptr;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free single-producer/single-consumer queue of array writes.
+// The sort thread pushes, the render loop drains. A push never blocks: when
+// the ring is full it fails and the caller falls back to marking the write in
+// the dirty tile bitmap, so the renderer rescans that part of the array.
+
+constexpr uint32_t WRITE_RING_CAPACITY = 1 << 16;
+
+struct WriteEvent {
+    int index;
+    int value;
+};
+
+struct WriteRing {
+    std::unique_ptr<WriteEvent[]> events;
+    uint32_t mask = 0;
+
+    alignas(64) std::atomic<uint32_t> head{0};
+    uint32_t cachedTail = 0;
+    uint64_t dropped = 0;
+
+    alignas(64) std::atomic<uint32_t> tail{0};
+    uint32_t cachedHead = 0;
+};
+
+// capacity must be a power of two.
+inline void write_ring_init(WriteRing& ring, uint32_t capacity) {
+    ring.events.reset(new WriteEvent[capacity]);
+    ring.mask = capacity - 1;
+    ring.head.store(0, std::memory_order_relaxed);
+    ring.tail.store(0, std::memory_order_relaxed);
+    ring.cachedTail = 0;
+    ring.cachedHead = 0;
+    ring.dropped = 0;
+}
+
+// Producer side. Returns false instead of waiting when the ring is full.
+inline bool write_ring_push(WriteRing& ring, int index, int value) {
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.cachedTail > ring.mask) {
+        ring.cachedTail = ring.tail.load(std::memory_order_acquire);
+        if (head - ring.cachedTail > ring.mask) {
+            ring.dropped++;
+            return false;
+        }
+    }
+
+    ring.events[head & ring.mask] = { index, value };
+    ring.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// Consumer side. Hands every event published so far to consume() in order
+// and returns how many there were.
+template <typename Consumer>
+inline int write_ring_drain(WriteRing& ring, Consumer consume) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    ring.cachedHead = ring.head.load(std::memory_order_acquire);
+
+    int count = 0;
+    for (; tail != ring.cachedHead; tail++, count++) {
+        consume(ring.events[tail & ring.mask]);
+    }
+    ring.tail.store(tail, std::memory_order_release);
+
+    return count;
+}